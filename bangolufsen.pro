@@ -1,6 +1,6 @@
 TEMPLATE  = lib
 CONFIG   += c++14 plugin
-QT       += websockets core quick
+QT       += websockets core quick network
 
 # === Version and build information ===========================================
 # If built in Buildroot use custom package version, otherwise Git
@@ -76,8 +76,41 @@ unix {
 QMAKE_SUBSTITUTES += bangolufsen.json.in version.txt.in
 # output path must be included for the output file from QMAKE_SUBSTITUTES
 INCLUDEPATH += $$OUT_PWD
-HEADERS  += src/bangolufsen.h
-SOURCES  += src/bangolufsen.cpp
+HEADERS  += src/artworkcache.h \
+            src/bangolufsen.h \
+            src/beodevice.h \
+            src/beohttpclient.h \
+            src/beometrics.h \
+            src/commandcoalescer.h \
+            src/contentcache.h \
+            src/deviceprofile.h \
+            src/discoverybackend.h \
+            src/entityshadow.h \
+            src/mdnsbrowser.h \
+            src/notificationdecoder.h \
+            src/notificationfilter.h \
+            src/notificationframer.h \
+            src/optimisticstate.h \
+            src/playbackclock.h \
+            src/productdiscovery.h \
+            src/reconnectbackoff.h
+SOURCES  += src/artworkcache.cpp \
+            src/bangolufsen.cpp \
+            src/beodevice.cpp \
+            src/beohttpclient.cpp \
+            src/beometrics.cpp \
+            src/commandcoalescer.cpp \
+            src/contentcache.cpp \
+            src/deviceprofile.cpp \
+            src/entityshadow.cpp \
+            src/mdnsbrowser.cpp \
+            src/notificationdecoder.cpp \
+            src/notificationfilter.cpp \
+            src/notificationframer.cpp \
+            src/optimisticstate.cpp \
+            src/playbackclock.cpp \
+            src/productdiscovery.cpp \
+            src/reconnectbackoff.cpp
 TARGET    = bangolufsen
 
 # Configure destination path. DESTDIR is set in qmake-destination-path.pri
@@ -93,6 +126,12 @@ unix {
     INSTALLS += target
 }
 
+# unit tests: "make tests" builds and runs them in $$OUT_PWD/tests, they only need Qt
+tests.commands = $(MKDIR) $$shell_path($$OUT_PWD/tests) && cd $$shell_path($$OUT_PWD/tests) && \
+                 $$QMAKE_QMAKE $$shell_path($$PWD/tests/tests.pro) && $(MAKE) check
+tests.CONFIG = phony
+QMAKE_EXTRA_TARGETS += tests
+
 DISTFILES += \
     dependencies.cfg \
     bangolufsen.json.in \
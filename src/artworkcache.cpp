@@ -0,0 +1,209 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "artworkcache.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <QUrl>
+
+ArtworkCache::ArtworkCache(QNetworkAccessManager *manager, const QString &directory, int imageSize,
+                           qint64 maxDiskSize, QObject *parent)
+    : QObject(parent),
+      m_manager(manager),
+      m_directory(directory),
+      m_imageSize(imageSize),
+      m_maxDiskSize(maxDiskSize),
+      m_memory(MEMORY_ENTRIES) {
+    m_directory.mkpath(".");
+
+    const QFileInfoList files = m_directory.entryInfoList(QDir::Files);
+    for (const QFileInfo &file : files) {
+        m_diskSize += file.size();
+    }
+    trimDisk();
+}
+
+ArtworkCache::~ArtworkCache() {
+    // waiting callers may be gone already, drop the downloads silently
+    for (QNetworkReply *reply : m_downloads) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+void ArtworkCache::request(const QString &url, const Handler &handler) {
+    if (url.isEmpty()) {
+        if (handler) {
+            handler(QString());
+        }
+        return;
+    }
+
+    // memory
+    if (QString *localUrl = m_memory.object(url)) {
+        if (handler) {
+            handler(*localUrl);
+        }
+        return;
+    }
+
+    // disk
+    QString path = m_directory.filePath(fileName(url));
+    QFile   file(path);
+    if (file.exists()) {
+        // the modification time orders the files for eviction
+        if (file.open(QIODevice::ReadWrite)) {
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            file.close();
+        }
+        QString localUrl = QUrl::fromLocalFile(path).toString();
+        m_memory.insert(url, new QString(localUrl));
+        if (handler) {
+            handler(localUrl);
+        }
+        return;
+    }
+
+    // download, merged with a running one for the same image
+    auto waiting = m_pending.find(url);
+    if (waiting != m_pending.end()) {
+        if (handler) {
+            waiting->append(handler);
+        }
+        return;
+    }
+
+    QList<Handler> handlers;
+    if (handler) {
+        handlers.append(handler);
+    }
+    m_pending.insert(url, handlers);
+
+    QNetworkReply *reply = m_manager->get(QNetworkRequest(QUrl(url)));
+    m_downloads.insert(url, reply);
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() { onDownloaded(url, reply); });
+    QTimer::singleShot(DOWNLOAD_TIMEOUT, reply, &QNetworkReply::abort);
+}
+
+void ArtworkCache::cancelAll() {
+    for (QNetworkReply *reply : m_downloads) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+    m_downloads.clear();
+
+    // the handlers may request images again, they start new downloads
+    const QHash<QString, QList<Handler>> pending = m_pending;
+    m_pending.clear();
+    for (const QList<Handler> &handlers : pending) {
+        for (const Handler &handler : handlers) {
+            handler(QString());
+        }
+    }
+}
+
+QString ArtworkCache::fileName(const QString &url) const {
+    return QString::fromLatin1(QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".jpg";
+}
+
+void ArtworkCache::onDownloaded(const QString &url, QNetworkReply *reply) {
+    m_downloads.remove(url);
+    reply->deleteLater();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        finish(url, QString());
+        return;
+    }
+
+    // the remote never shows the cover larger, a smaller file also loads faster in the UI.
+    // The image is decoded straight to that size, a JPEG decoder then skips most of the full size image.
+    QByteArray   data = reply->readAll();
+    QBuffer      buffer(&data);
+    QImageReader reader(&buffer);
+    QSize        size = reader.size();
+    if (size.width() > m_imageSize || size.height() > m_imageSize) {
+        reader.setScaledSize(size.scaled(m_imageSize, m_imageSize, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        finish(url, QString());
+        return;
+    }
+    // formats that do not tell their size before decoding
+    if (image.width() > m_imageSize || image.height() > m_imageSize) {
+        image = image.scaled(m_imageSize, m_imageSize, Qt::KeepAspectRatio, Qt::FastTransformation);
+    }
+
+    QString path = m_directory.filePath(fileName(url));
+    if (!image.save(path, "JPG", 85)) {
+        finish(url, QString());
+        return;
+    }
+    m_diskSize += QFileInfo(path).size();
+    trimDisk();
+
+    QString localUrl = QUrl::fromLocalFile(path).toString();
+    m_memory.insert(url, new QString(localUrl));
+    finish(url, localUrl);
+}
+
+void ArtworkCache::finish(const QString &url, const QString &localUrl) {
+    const QList<Handler> handlers = m_pending.take(url);
+    for (const Handler &handler : handlers) {
+        handler(localUrl);
+    }
+}
+
+void ArtworkCache::trimDisk() {
+    if (m_diskSize <= m_maxDiskSize) {
+        return;
+    }
+
+    // evict the least recently used files until there is some room again
+    const QFileInfoList files = m_directory.entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+    for (const QFileInfo &file : files) {
+        if (m_diskSize <= m_maxDiskSize * 9 / 10) {
+            break;
+        }
+        if (QFile::remove(file.filePath())) {
+            m_diskSize -= file.size();
+        }
+    }
+
+    // the memory entries of evicted files are stale
+    const QList<QString> urls = m_memory.keys();
+    for (const QString &url : urls) {
+        if (!m_directory.exists(fileName(url))) {
+            m_memory.remove(url);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QCache>
+#include <QDir>
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QString>
+
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// ARTWORK CACHE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Cache of album art, shared by all products.
+/// Images are downloaded once, downscaled to the size shown by the remote and stored on disk. A cached image is handed
+/// out as a local file URL, so the UI never fetches the full size image from the product or the internet again.
+/// The most recently used entries are kept in memory, the disk store is capped in size and evicts the least recently
+/// used files. Requests for an image that is already being downloaded wait for the same download.
+class ArtworkCache : public QObject {
+    Q_OBJECT
+
+ public:
+    /// Called with the local file URL of the image, or an empty string if it could not be loaded.
+    typedef std::function<void(const QString& localUrl)> Handler;
+
+    static const int DEFAULT_IMAGE_SIZE = 400;
+    static const int DEFAULT_DISK_SIZE = 20 * 1024 * 1024;
+    static const int MEMORY_ENTRIES = 64;
+    static const int DOWNLOAD_TIMEOUT = 10000;
+
+    ArtworkCache(QNetworkAccessManager* manager, const QString& directory, int imageSize = DEFAULT_IMAGE_SIZE,
+                 qint64 maxDiskSize = DEFAULT_DISK_SIZE, QObject* parent = nullptr);
+    ~ArtworkCache() override;
+
+    /// Calls handler with the cached image of url. A cached image is handed out immediately, during the call.
+    void request(const QString& url, const Handler& handler);
+
+    /// Loads the image of url into the cache without waiting for it.
+    void prefetch(const QString& url) { request(url, Handler()); }
+
+    /// Aborts all downloads, e.g. on standby of the remote. Waiting callers get an empty string.
+    void cancelAll();
+
+ private:
+    QString fileName(const QString& url) const;
+    void    onDownloaded(const QString& url, QNetworkReply* reply);
+    void    finish(const QString& url, const QString& localUrl);
+    void    trimDisk();
+
+    QNetworkAccessManager* m_manager;
+    QDir                   m_directory;
+    int                    m_imageSize;
+    qint64                 m_maxDiskSize;
+    qint64                 m_diskSize = 0;
+
+    // url -> local file URL of the recently used images
+    QCache<QString, QString> m_memory;
+
+    // url -> callers waiting for the download
+    QHash<QString, QList<Handler>>  m_pending;
+    QHash<QString, QNetworkReply*> m_downloads;
+};
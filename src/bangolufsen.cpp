@@ -24,11 +24,25 @@
 
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QRegularExpression>
+#include <QStandardPaths>
 #include <QtDebug>
 
+#include <limits>
+#include <memory>
+
 #include "yio-interface/entities/mediaplayerinterface.h"
 
+static const char KEY_DEVICES[] = "devices";
+static const char KEY_FRIENDLY_NAME[] = "friendly_name";
+static const char KEY_METRICS_LOG_INTERVAL[] = "metrics_log_interval";
+static const char KEY_ARTWORK_SIZE[] = "artwork_size";
+static const char KEY_ARTWORK_CACHE_SIZE[] = "artwork_cache_size";
+static const char KEY_DISCOVERY[] = "discovery";
+static const char KEY_NOTIFICATION_FILTER[] = "notification_filter";
+static const char KEY_REQUEST_TIMEOUTS[] = "request_timeouts";
+
 BangOlufsenPlugin::BangOlufsenPlugin() : Plugin("yio.plugin.bangolufsen", USE_WORKER_THREAD) {}
 
 Integration *BangOlufsenPlugin::createIntegration(const QVariantMap &config, EntitiesInterface *entities,
@@ -46,69 +60,104 @@ Integration *BangOlufsenPlugin::createIntegration(const QVariantMap &config, Ent
 BangOlufsen::BangOlufsen(const QVariantMap &config, EntitiesInterface *entities, NotificationsInterface *notifications,
                          YioAPIInterface *api, ConfigInterface *configObj, Plugin *plugin)
     : Integration(config, entities, notifications, api, configObj, plugin) {
-    for (QVariantMap::const_iterator iter = config.begin(); iter != config.end(); ++iter) {
-        if (iter.key() == Integration::OBJ_DATA) {
-            QVariantMap map = iter.value().toMap();
-            m_ip = map.value(Integration::KEY_DATA_IP).toString();
-            m_baseUrl = QString("http://").append(m_ip).append(":8080");
-            m_entityId = map.value(Integration::KEY_ENTITY_ID).toString();
+    // one manager for all notification streams and REST requests, it keeps the connections alive
+    m_manager = new QNetworkAccessManager(this);
+
+    // album art cache, shared by all products
+    QVariantMap data = config.value(Integration::OBJ_DATA).toMap();
+    int         artworkSize = data.value(KEY_ARTWORK_SIZE, ArtworkCache::DEFAULT_IMAGE_SIZE).toInt();
+    qint64      artworkCacheSize = data.value(KEY_ARTWORK_CACHE_SIZE, ArtworkCache::DEFAULT_DISK_SIZE / (1024 * 1024))
+                                  .toLongLong() * 1024 * 1024;
+    QString     artworkDirectory =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation).append("/bangolufsen/artwork");
+    m_artwork = new ArtworkCache(m_manager, artworkDirectory, artworkSize, artworkCacheSize, this);
+
+    // follows the products to new addresses
+    if (data.value(KEY_DISCOVERY, true).toBool()) {
+        m_discovery = new ProductDiscovery(new MdnsBrowser(), m_manager, this);
+        QObject::connect(m_discovery, &ProductDiscovery::productFound, this, &BangOlufsen::onProductFound);
+    }
+
+    // notifications of the player screen are held back while it is not visible
+    NotificationFilter::Policy latestOnly;
+    latestOnly.action = NotificationFilter::LATEST_ONLY;
+    m_hiddenPolicies.insert(BeoNotification::PROGRESS_INFORMATION, latestOnly);
+    m_hiddenPolicies.insert(BeoNotification::NOW_PLAYING_STORED_MUSIC, latestOnly);
+    m_hiddenPolicies.insert(BeoNotification::NOW_PLAYING_NET_RADIO, latestOnly);
+
+    const QVariantMap filter = data.value(KEY_NOTIFICATION_FILTER).toMap();
+    for (auto iter = filter.cbegin(); iter != filter.cend(); ++iter) {
+        BeoNotification::Type      type = NotificationDecoder::typeFromString(iter.key());
+        NotificationFilter::Policy policy;
+        if (type == BeoNotification::UNKNOWN || !NotificationFilter::policyFromVariant(iter.value(), &policy)) {
+            qCWarning(m_logCategory) << "Invalid notification filter" << iter.key() << iter.value();
+            continue;
         }
+        m_hiddenPolicies.insert(type, policy);
     }
 
-    // set up polling timer
+    // request deadlines per class, the client defaults apply to the ones not configured
+    const QVariantMap timeouts = data.value(KEY_REQUEST_TIMEOUTS).toMap();
+    m_requestTimeouts[BeoHttpClient::INTERACTIVE] = timeouts.value("command").toInt();
+    m_requestTimeouts[BeoHttpClient::NORMAL] = timeouts.value("query").toInt();
+    m_requestTimeouts[BeoHttpClient::BACKGROUND] = timeouts.value("background").toInt();
+
+    // set up polling timer, shared by all products. It fires when the next product is due.
     m_pollingTimer = new QTimer(this);
-    m_pollingTimer->setInterval(10000);
+    m_pollingTimer->setSingleShot(true);
     QObject::connect(m_pollingTimer, &QTimer::timeout, this, &BangOlufsen::onPollingTimerTimeout);
 
-    m_manager = new QNetworkAccessManager(this);
+    // periodic metrics dump, off unless configured
+    m_metricsTimer = new QTimer(this);
+    QObject::connect(m_metricsTimer, &QTimer::timeout, this, &BangOlufsen::logMetrics);
+
+    // capabilities of the products from the previous run, the entities are registered before any product answered
+    m_profiles = new DeviceProfileStore(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation).append("/bangolufsen/profiles"));
+
+    for (QVariantMap::const_iterator iter = config.begin(); iter != config.end(); ++iter) {
+        if (iter.key() == Integration::OBJ_DATA) {
+            QVariantMap  map = iter.value().toMap();
+            QVariantList devices = map.value(KEY_DEVICES).toList();
+            m_metricsTimer->setInterval(map.value(KEY_METRICS_LOG_INTERVAL, 0).toInt() * 1000);
+
+            // single product configuration
+            if (devices.isEmpty() && map.contains(Integration::KEY_DATA_IP)) {
+                devices.append(map);
+            }
 
-    // handle closed connection
-    QObject::connect(m_manager, &QNetworkAccessManager::finished, this,
-                     [=]() {
-                         if (!m_userDisconnect) {
-                             qCDebug(m_logCategory)
-                                 << "Manager finished: Bang & Olufsen product dropped the connection, reconnecting ...";
-                             disconnect();
-                             connect();
-                         }
-                     });
-
-    // add available entity
-    QStringList supportedFeatures;
-    supportedFeatures << "SOURCE"
-                      << "APP_NAME"
-                      << "VOLUME"
-                      << "VOLUME_UP"
-                      << "VOLUME_DOWN"
-                      << "VOLUME_SET"
-                      << "MUTE"
-                      << "MUTE_SET"
-                      << "MEDIA_TYPE"
-                      << "MEDIA_TITLE"
-                      << "MEDIA_ARTIST"
-                      << "MEDIA_ALBUM"
-                      << "MEDIA_DURATION"
-                      << "MEDIA_POSITION"
-                      << "MEDIA_IMAGE"
-                      << "PLAY"
-                      << "PAUSE"
-                      << "STOP"
-                      << "PREVIOUS"
-                      << "NEXT"
-                      << "SEEK"
-                      << "SHUFFLE"
-                      << "TURN_ON"
-                      << "TURN_OFF";
-    addAvailableEntity(m_entityId, "media_player", integrationId(), friendlyName(), supportedFeatures);
+            for (const QVariant &device : devices) {
+                QVariantMap deviceMap = device.toMap();
+                QString     ip = deviceMap.value(Integration::KEY_DATA_IP).toString();
+                QString     entityId = deviceMap.value(Integration::KEY_ENTITY_ID).toString();
+                QString     name = deviceMap.value(KEY_FRIENDLY_NAME, friendlyName()).toString();
+                if (ip.isEmpty()) {
+                    qCWarning(m_logCategory) << "Skipping Bang & Olufsen product without IP address";
+                    continue;
+                }
+                if (entityId.isEmpty()) {
+                    entityId = QString("%1.%2").arg(integrationId(), ip);
+                }
+                addDevice(ip, entityId, name);
+            }
+        }
+    }
 }
 
 BangOlufsen::~BangOlufsen() {
-    if (m_reply != nullptr) {
-        m_reply->abort();
-        m_reply->disconnect();
-        delete m_reply;
-        m_reply = nullptr;
-    }
+    // the streams are children of the manager, close them first
+    qDeleteAll(m_devices);
+    m_devices.clear();
+    m_devicesByEntity.clear();
+    m_deviceNames.clear();
+
+    // the downloads of the cache and the discovery probes are children of the manager as well
+    delete m_artwork;
+    m_artwork = nullptr;
+    delete m_discovery;
+    m_discovery = nullptr;
+    delete m_profiles;
+    m_profiles = nullptr;
 
     if (m_manager != nullptr) {
         delete m_manager;
@@ -116,125 +165,56 @@ BangOlufsen::~BangOlufsen() {
     }
 }
 
-void BangOlufsen::updateEntity(const QString &entity_id, const QVariantMap &map) {
-    EntityInterface *entity = m_entities->getEntityInterface(entity_id);
-    if (entity) {
-        QString state = getState(map);
-        if (state == "play") {
-            entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
-        } else if (state == "pause") {
-            entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
-        } else if (state == "stop") {
-            entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
-        }
-
-        QString source = getSource(map);
-        if (entity->isSupported(MediaPlayerDef::F_SOURCE) && !source.isEmpty()) {
-            entity->updateAttrByIndex(MediaPlayerDef::SOURCE, source);
-        }
-
-        int volume = getVolume(map);
-        if (entity->isSupported(MediaPlayerDef::F_VOLUME_SET) && volume != -1) {
-            entity->updateAttrByIndex(MediaPlayerDef::VOLUME, volume);
-        }
-
-        bool muted = getMuted(map);
-        if (entity->isSupported(MediaPlayerDef::F_MUTE_SET) && entity->isSupported(MediaPlayerDef::F_MUTE)) {
-            entity->updateAttrByIndex(MediaPlayerDef::MUTED, muted);
-        }
-
-        QVariantMap musicInfo = getMusicInfo(map);
-        //        // media type
-        //        if (entity->isSupported(MediaPlayerDef::F_MEDIA_TYPE) && haAttr.contains("media_content_type")) {
-        //            entity->updateAttrByIndex(MediaPlayerDef::MEDIATYPE,
-        //            haAttr.value("media_content_type").toString());
-        //        }
-
-        // media image
-        if (entity->isSupported(MediaPlayerDef::F_MEDIA_IMAGE) && musicInfo.contains("mediaUrl")) {
-            entity->updateAttrByIndex(MediaPlayerDef::MEDIAIMAGE, musicInfo.value("mediaUrl").toString());
-        }
-
-        // media title
-        if (entity->isSupported(MediaPlayerDef::F_MEDIA_TITLE) && musicInfo.contains("mediaTrack")) {
-            entity->updateAttrByIndex(MediaPlayerDef::MEDIATITLE, musicInfo.value("mediaTrack").toString());
-        }
+void BangOlufsen::addDevice(const QString &ip, const QString &entityId, const QString &name) {
+    if (m_devicesByEntity.contains(entityId)) {
+        qCWarning(m_logCategory) << "Duplicate Bang & Olufsen entity" << entityId;
+        return;
+    }
 
-        // media artist
-        if (entity->isSupported(MediaPlayerDef::F_MEDIA_ARTIST) && musicInfo.contains("mediaArtist")) {
-            entity->updateAttrByIndex(MediaPlayerDef::MEDIAARTIST, musicInfo.value("mediaArtist").toString());
+    BeoDevice *device = new BeoDevice(ip, entityId, m_manager, m_artwork, m_entities, m_logCategory, this);
+    device->setProfile(m_profiles->load(entityId));
+    for (int priority = BeoHttpClient::INTERACTIVE; priority <= BeoHttpClient::BACKGROUND; priority++) {
+        device->setRequestTimeout(static_cast<BeoHttpClient::Priority>(priority), m_requestTimeouts[priority]);
+    }
+    QObject::connect(device, &BeoDevice::connectedChanged, this, &BangOlufsen::onDeviceConnectedChanged);
+    QObject::connect(device, &BeoDevice::pollScheduleChanged, this, &BangOlufsen::schedulePolling);
+    QObject::connect(device, &BeoDevice::staleChanged, this,
+                     [=](bool stale) { emit staleChanged(device->entityId(), stale); });
+    QObject::connect(device, &BeoDevice::unreachable, this, [=]() {
+        if (m_discovery) {
+            m_discovery->refresh();
         }
-
-        // media duration
-        int duration = getDuration(map);
-        if (entity->isSupported(MediaPlayerDef::F_MEDIA_DURATION)) {
-            entity->updateAttrByIndex(MediaPlayerDef::MEDIADURATION, duration);
+    });
+    QObject::connect(device, &BeoDevice::profileChanged, this, [=]() {
+        if (!m_profiles->save(device->entityId(), device->profile())) {
+            qCWarning(m_logCategory) << "Cannot store the profile of Bang & Olufsen product" << device->entityId();
         }
+        // the entity was registered with the features known at startup
+        qCInfo(m_logCategory) << "Bang & Olufsen product" << device->entityId() << "supports"
+                              << device->profile().features << ", the features apply from the next start";
+    });
+    m_devices.append(device);
+    m_devicesByEntity.insert(entityId, device);
+    m_deviceNames.insert(device, name);
 
-        // media position
-        int positon = getPosition(map);
-        if (entity->isSupported(MediaPlayerDef::F_MEDIA_POSITION)) {
-            entity->updateAttrByIndex(MediaPlayerDef::MEDIAPROGRESS, positon);
-        }
-    }
+    const BeoDeviceProfile &profile = device->profile();
+    QStringList             features = profile.isValid() ? profile.features : BeoDeviceProfile::defaultFeatures();
+    addAvailableEntity(entityId, "media_player", integrationId(), name, features);
 }
 
 void BangOlufsen::connect() {
-    if (!m_pollingTimer->isActive()) {
-        m_pollingTimer->start();
-    }
-
     if (m_state != CONNECTING && m_state != CONNECTED) {
         setState(CONNECTING);
-        m_userDisconnect = false;
-        qCDebug(m_logCategory) << "Connecting to a Bang & Olufsen product:" << m_baseUrl;
-
-        QNetworkRequest request;
-        request.setUrl(QUrl(m_baseUrl + "/BeoNotify/Notifications"));
-
-        m_reply = m_manager->get(request);
-
-        // read the streaming json
-        QObject::connect(m_reply, &QIODevice::readyRead, this, [=]() {
-            if (!m_reply->error()) {
-                setState(CONNECTED);
-                QString     answer = m_reply->readAll();
-                QStringList answers = answer.split("\r\n\r\n");
-
-                for (int i = 0; i < answers.length(); i++) {
-                    QString answerSingle = answers[i].trimmed();
-
-                    QVariantMap map;
-                    if (answerSingle != "") {
-                        // convert to json
-                        QJsonParseError parseerror;
-                        QJsonDocument   doc = QJsonDocument::fromJson(answerSingle.toUtf8(), &parseerror);
-                        if (parseerror.error != QJsonParseError::NoError) {
-                            qCWarning(m_logCategory) << "JSON error : " << parseerror.errorString();
-                            return;
-                        }
-
-                        // createa a map object and update entity
-                        map = doc.toVariant().toMap().value("notification").toMap();
-                        updateEntity(m_entityId, map);
-                    }
-                }
-            } else {
-                qCDebug(m_logCategory) << "Cannot connect" << m_reply->errorString();
-                disconnect();
-            }
-        });
-
-        // handle dropped connection
-        QObject::connect(m_reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error), this,
-                         [=](QNetworkReply::NetworkError code) {
-                             if (!m_userDisconnect) {
-                                 qCDebug(m_logCategory)
-                                     << "Bang & Olufsen product disconnected, reconnecting ..." << code;
-                                 disconnect();
-                                 connect();
-                             }
-                         });
+        for (BeoDevice *device : m_devices) {
+            device->connectToDevice();
+            device->resetPolling();
+        }
+        if (m_metricsTimer->interval() > 0) {
+            m_metricsTimer->start();
+        }
+        if (m_discovery) {
+            m_discovery->start();
+        }
     }
 }
 
@@ -243,319 +223,250 @@ void BangOlufsen::disconnect() {
         m_pollingTimer->stop();
         qCDebug(m_logCategory) << "Polling timer stopped.";
     }
+    m_metricsTimer->stop();
+    if (m_discovery) {
+        m_discovery->stop();
+    }
+    // set the state first, the devices report their disconnect while closing
     if (m_state != DISCONNECTED) {
-        qCDebug(m_logCategory) << "Disconnecting a Bang & Olufsen product";
-        m_userDisconnect = true;
-        m_reply->abort();
-        m_reply->disconnect();
         setState(DISCONNECTED);
     }
+    // also when already disconnected, commands may have been sent meanwhile
+    for (BeoDevice *device : m_devices) {
+        device->disconnectFromDevice();
+    }
+    // no downloads through standby, they do not go through the clients of the devices
+    m_artwork->cancelAll();
 }
 
-void BangOlufsen::enterStandby() {
-    disconnect();
+QVariantMap BangOlufsen::metrics() const {
+    QVariantMap map;
+    for (BeoDevice *device : m_devices) {
+        map.insert(device->entityId(), device->metrics());
+    }
+    map.insert("resources", resources());
+    return map;
 }
 
-void BangOlufsen::leaveStandby() {
-    connect();
+QVariantMap BangOlufsen::resources() const {
+    // the replies of all products, downloads and probes are children of the manager until they are deleted
+    QVariantMap map;
+    map.insert("objects", findChildren<QObject *>().size());
+    map.insert("replies", m_manager->findChildren<QNetworkReply *>().size());
+    return map;
 }
 
-void BangOlufsen::sendCommand(const QString &type, const QString &entity_id, int command, const QVariant &param) {
-    if (entity_id == m_entityId && type == "media_player") {
-        if (command == MediaPlayerDef::C_VOLUME_SET) {
-            setVolume(param.toInt());
-        } else if (command == MediaPlayerDef::C_PLAY) {
-            Play();
-        } else if (command == MediaPlayerDef::C_MUTE) {
-            EntityInterface *     entity = m_entities->getEntityInterface(entity_id);
-            MediaPlayerInterface *me = static_cast<MediaPlayerInterface *>(entity->getSpecificInterface());
-            if (entity) {
-                setMute(!me->muted());
-            }
-        } else if (command == MediaPlayerDef::C_PAUSE) {
-            Pause();
-        } else if (command == MediaPlayerDef::C_PREVIOUS) {
-            Prev();
-        } else if (command == MediaPlayerDef::C_NEXT) {
-            Next();
-        } else if (command == MediaPlayerDef::C_TURNON) {
-            TurnOn();
-        } else if (command == MediaPlayerDef::C_TURNOFF) {
-            Standby();
-        }
-    }
+int BangOlufsen::position(const QString &entityId) const {
+    BeoDevice *device = m_devicesByEntity.value(entityId);
+    return device ? device->position() : 0;
 }
 
-void BangOlufsen::getRequest(const QString &url) {
-    // create new networkacces manager and request
-    QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-    QNetworkRequest        request;
-
-    QObject *context = new QObject(this);
-
-    // connect to finish signal
-    QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply *reply) {
-        if (reply->error()) {
-            qCWarning(m_logCategory) << reply->errorString();
-            reply->deleteLater();
-            context->deleteLater();
-            manager->deleteLater();
-            return;
-        }
-
-        QString     answer = reply->readAll();
-        QVariantMap map;
-        if (answer != "") {
-            // convert to json
-            QJsonParseError parseerror;
-            QJsonDocument   doc = QJsonDocument::fromJson(answer.toUtf8(), &parseerror);
-            if (parseerror.error != QJsonParseError::NoError) {
-                qCWarning(m_logCategory) << "JSON error : " << parseerror.errorString();
-                return;
-            }
-
-            // createa a map object
-            map = doc.toVariant().toMap();
-            emit requestReady(map, url);
-        }
-
-        reply->deleteLater();
-        context->deleteLater();
-        manager->deleteLater();
-    });
-
-    QObject::connect(
-        manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
-
-    // set the URL
-    // url = "/BeoDevice/powerManagement/standby"
-    request.setUrl(QUrl(m_baseUrl + url));
+void BangOlufsen::setUiVisible(bool visible) {
+    if (visible == m_uiVisible) {
+        return;
+    }
+    m_uiVisible = visible;
 
-    // send the get request
-    manager->get(request);
+    for (BeoDevice *device : m_devices) {
+        device->setNotificationPolicies(visible ? NotificationFilter::Policies() : m_hiddenPolicies);
+    }
 }
 
-void BangOlufsen::postRequest(const QString &url, const QString &params) {
-    // create new networkacces manager and request
-    QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-    QNetworkRequest        request;
-
-    QObject *context = new QObject(this);
-
-    // connect to finish signal
-    QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply *reply) {
-        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        qCDebug(m_logCategory) << "POST REQUEST " << statusCode;
-        reply->deleteLater();
-        context->deleteLater();
-        manager->deleteLater();
-    });
-
-    QObject::connect(
-        manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
-
-    request.setUrl(QUrl(m_baseUrl + url + params));
-
-    // send the get request
-    manager->post(request, "");
+bool BangOlufsen::isStale(const QString &entityId) const {
+    BeoDevice *device = m_devicesByEntity.value(entityId);
+    return device && device->isStale();
 }
 
-void BangOlufsen::putRequest(const QString &url, const QVariantMap &params) {
-    // create new networkacces manager and request
-    QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-    QNetworkRequest        request;
-
-    QObject *context = new QObject(this);
-
-    // connect to finish signal
-    QObject::connect(manager, &QNetworkAccessManager::finished, context, [=](QNetworkReply *reply) {
-        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        qCDebug(m_logCategory) << "PUT REQUEST " << statusCode << reply->readAll();
-        reply->deleteLater();
-        context->deleteLater();
-        manager->deleteLater();
-    });
-
-    QObject::connect(
-        manager, &QNetworkAccessManager::networkAccessibleChanged, context,
-        [=](QNetworkAccessManager::NetworkAccessibility accessibility) { qCDebug(m_logCategory) << accessibility; });
-
-    request.setUrl(QUrl(m_baseUrl + url));
-
-    QJsonDocument json = QJsonDocument::fromVariant(params);
-    QString       jsonString = json.toJson(QJsonDocument::JsonFormat::Compact);
-    QByteArray    data = jsonString.toUtf8();
-
-    // send the get request
-    manager->put(request, data);
+void BangOlufsen::setProgressInterval(int msecs) {
+    for (BeoDevice *device : m_devices) {
+        device->setProgressInterval(msecs);
+    }
 }
 
-void BangOlufsen::putRequest(const QString &url) {
-    putRequest(url, QVariantMap());
+void BangOlufsen::prefetchArtwork(const QString &url) {
+    m_artwork->prefetch(url);
 }
 
-int BangOlufsen::getVolume(const QVariantMap &map) {
-    int volume = -1;
-    if (map.contains("data") && map.value("type").toString() == "VOLUME") {
-        volume = static_cast<int>(map.value("data").toMap().value("speaker").toMap().value("level").toDouble());
+void BangOlufsen::logMetrics() {
+    for (BeoDevice *device : m_devices) {
+        QByteArray json = QJsonDocument(QJsonObject::fromVariantMap(device->metrics())).toJson(QJsonDocument::Compact);
+        qCInfo(m_logCategory).noquote() << "Metrics" << device->entityId() << json;
     }
-    return volume;
+    qCInfo(m_logCategory) << "Resources" << resources();
 }
 
-bool BangOlufsen::getMuted(const QVariantMap &map) {
-    bool muted = false;
-    if (map.contains("data") && map.value("type").toString() == "VOLUME") {
-        muted = map.value("data").toMap().value("speaker").toMap().value("muted").toBool();
-    }
-    return muted;
+void BangOlufsen::enterStandby() {
+    disconnect();
 }
 
-QString BangOlufsen::getSource(const QVariantMap &map) {
-    QString source;
-    if (map.contains("data") && map.value("type").toString() == "SOURCE") {
-        source = map.value("data")
-                     .toMap()
-                     .value("primaryExperience")
-                     .toMap()
-                     .value("source")
-                     .toMap()
-                     .value("friendlyName")
-                     .toString();
-    }
-    return source;
+void BangOlufsen::leaveStandby() {
+    connect();
 }
 
-QString BangOlufsen::getState(const QVariantMap &map) {
-    QString state;
-    if (map.contains("data") && map.value("type").toString() == "PROGRESS_INFORMATION") {
-        state = map.value("data").toMap().value("state").toString();
+void BangOlufsen::sendCommand(const QString &type, const QString &entity_id, int command, const QVariant &param) {
+    if (type == "media_player") {
+        BeoDevice *device = m_devicesByEntity.value(entity_id);
+        if (device) {
+            device->sendCommand(command, param);
+        }
     }
-    return state;
 }
 
-void BangOlufsen::getStandby() {
-    QString url = "/BeoDevice/powerManagement/standby";
-
-    QObject *context = new QObject(this);
+void BangOlufsen::sendGroupCommand(const QString &entityId, int command, const QVariant &param) {
+    BeoDevice *device = m_devicesByEntity.value(entityId);
+    if (!device) {
+        return;
+    }
 
-    QObject::connect(this, &BangOlufsen::requestReady, context, [=](const QVariantMap &map, const QString &rUrl) {
-        if (rUrl == url) {
-            EntityInterface *entity = m_entities->getEntityInterface(m_entityId);
+    // skipping tracks is handled by the experience itself, sending it to every member would skip several tracks
+    QList<BeoDevice *> devices;
+    if (command == MediaPlayerDef::C_NEXT || command == MediaPlayerDef::C_PREVIOUS) {
+        devices.append(device);
+    } else {
+        devices = groupMembers(device);
+    }
 
-            if (entity && entity->isSupported(MediaPlayerDef::F_TURN_ON) &&
-                entity->isSupported(MediaPlayerDef::F_TURN_OFF)) {
-                if (map.contains("standby") && map.value("standby").toMap().value("powerState").toString() == "on") {
-                    entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::ON);
-                } else {
-                    entity->updateAttrByIndex(MediaPlayerDef::STATE, MediaPlayerDef::OFF);
-                }
+    fanOut(
+        devices,
+        [=](BeoDevice *member, const BeoDevice::DoneCallback &done) { member->sendCommand(command, param, done); },
+        [=](int failed) {
+            if (failed > 0) {
+                qCWarning(m_logCategory) << "Group command" << command << "failed on" << failed << "products";
             }
-        }
-        context->deleteLater();
-    });
-
-    getRequest(url);
+            emit groupCommandFinished(entityId, command, failed == 0);
+        });
 }
 
-QVariantMap BangOlufsen::getMusicInfo(const QVariantMap &map) {
-    QVariantMap musicInfo;
-    if (map.value("data").toMap().contains("trackImage") &&
-        map.value("type").toString() == "NOW_PLAYING_STORED_MUSIC") {
-        if (map.value("data").toMap().contains("trackImage") &&
-            map.value("data").toMap().value("trackImage").toList().length() > 0) {
-            musicInfo.insert("mediaUrl",
-                             map.value("data").toMap().value("trackImage").toList()[0].toMap().value("url").toString());
-        }
-        musicInfo.insert("mediaArtist", map.value("data").toMap().value("artist").toString());
-        musicInfo.insert("mediaTrack", map.value("data").toMap().value("name").toString());
-        musicInfo.insert("mediaAlbum", map.value("data").toMap().value("album").toString());
-    }
-
-    if (map.value("type").toString() == "NOW_PLAYING_NET_RADIO") {
-        if (map.value("data").toMap().contains("image") &&
-            map.value("data").toMap().value("image").toList().length() > 0) {
-            musicInfo.insert("mediaUrl",
-                             map.value("data").toMap().value("image").toList()[0].toMap().value("url").toString());
-        }
-        musicInfo.insert("mediaArtist", map.value("data").toMap().value("name").toString());
-        musicInfo.insert("mediaTrack", map.value("data").toMap().value("liveDescription").toString());
-        musicInfo.insert("mediaAlbum", "");
-    }
+void BangOlufsen::joinExperience(const QStringList &entityIds) {
+    fanOut(
+        devicesByEntity(entityIds),
+        [](BeoDevice *device, const BeoDevice::DoneCallback &done) { device->joinExperience(done); },
+        [=](int failed) { qCDebug(m_logCategory) << "Joined experience" << entityIds << "failed:" << failed; });
+}
 
-    return musicInfo;
+void BangOlufsen::leaveExperience(const QStringList &entityIds) {
+    fanOut(
+        devicesByEntity(entityIds),
+        [](BeoDevice *device, const BeoDevice::DoneCallback &done) { device->leaveExperience(done); },
+        [=](int failed) { qCDebug(m_logCategory) << "Left experience" << entityIds << "failed:" << failed; });
 }
 
-int BangOlufsen::getPosition(const QVariantMap &map) {
-    int position = 0;
-    if (map.contains("data") && map.value("type").toString() == "PROGRESS_INFORMATION") {
-        position = map.value("data").toMap().value("position").toInt();
+void BangOlufsen::loadSources(const QString &entityId) {
+    BeoDevice *device = m_devicesByEntity.value(entityId);
+    if (!device) {
+        emit sourcesLoaded(entityId, false, QVariantList());
+        return;
     }
-    return position;
+    device->getSources([=](bool ok, const QVariantList &sources) { emit sourcesLoaded(entityId, ok, sources); });
 }
 
-int BangOlufsen::getDuration(const QVariantMap &map) {
-    int duration = 0;
-    if (map.contains("data") && map.value("type").toString() == "PROGRESS_INFORMATION") {
-        duration = map.value("data").toMap().value("totalDuration").toInt();
+void BangOlufsen::browse(const QString &entityId, const QString &path, int offset, int count) {
+    BeoDevice *device = m_devicesByEntity.value(entityId);
+    if (!device) {
+        emit contentLoaded(entityId, path, offset, false, QVariantMap());
+        return;
     }
-    return duration;
+    device->browse(path, offset, count, [=](bool ok, const QJsonObject &page) {
+        emit contentLoaded(entityId, path, offset, ok, page.toVariantMap());
+    });
 }
 
-void BangOlufsen::setVolume(const int &volume) {
-    QVariantMap data;
-    data.insert("level", volume);
-    putRequest("/BeoZone/Zone/Sound/Volume/Speaker/Level", data);
+QList<BeoDevice *> BangOlufsen::groupMembers(BeoDevice *device) const {
+    QList<BeoDevice *> members;
+    members.append(device);
+    for (BeoDevice *other : m_devices) {
+        if (other != device && other->isGroupedWith(device)) {
+            members.append(other);
+        }
+    }
+    return members;
 }
 
-void BangOlufsen::setMute(const bool &value) {
-    QVariantMap data;
-    data.insert("muted", value);
-    putRequest("/BeoZone/Zone/Sound/Volume/Speaker/Muted", data);
+QList<BeoDevice *> BangOlufsen::devicesByEntity(const QStringList &entityIds) const {
+    QList<BeoDevice *> devices;
+    for (const QString &entityId : entityIds) {
+        BeoDevice *device = m_devicesByEntity.value(entityId);
+        if (device) {
+            devices.append(device);
+        }
+    }
+    return devices;
 }
 
-void BangOlufsen::Play() {
-    postRequest("/BeoZone/Zone/Stream/Play", "");
-    postRequest("/BeoZone/Zone/Stream/Play/Release", "");
-}
+void BangOlufsen::fanOut(const QList<BeoDevice *> &devices, const DeviceAction &action,
+                         const std::function<void(int failed)> &finished) {
+    if (devices.isEmpty()) {
+        finished(0);
+        return;
+    }
 
-void BangOlufsen::Pause() {
-    postRequest("/BeoZone/Zone/Stream/Pause", "");
-    postRequest("/BeoZone/Zone/Stream/Pause/Release", "");
+    // all requests are issued at once, finished is called when the last product answered
+    auto remaining = std::make_shared<int>(devices.size());
+    auto failed = std::make_shared<int>(0);
+    for (BeoDevice *device : devices) {
+        action(device, [=](bool success) {
+            if (!success) {
+                (*failed)++;
+            }
+            if (--(*remaining) == 0) {
+                finished(*failed);
+            }
+        });
+    }
 }
 
-void BangOlufsen::Stop() {
-    postRequest("/BeoZone/Zone/Stream/Stop", "");
-    postRequest("/BeoZone/Zone/Stream/Stop/Release", "");
+void BangOlufsen::onProductFound(const BeoProductInfo &product) {
+    for (BeoDevice *device : m_devices) {
+        // until a product was reached once its serial number is unknown, the name of the setup identifies it then
+        bool matches = device->serialNumber().isEmpty()
+                           ? !device->isConnected() && m_deviceNames.value(device) == product.friendlyName
+                           : device->serialNumber() == product.serialNumber;
+        if (matches) {
+            // a reachable product keeps its address, e.g. a configured host name is not replaced by its IP address
+            if (!device->isConnected()) {
+                device->setAddress(product.address);
+                // the product answered the probe, the network is back and the backoff need not be waited for
+                device->reconnectNow();
+            }
+            return;
+        }
+    }
+    qCDebug(m_logCategory) << "Found Bang & Olufsen product" << product.friendlyName << product.serialNumber
+                           << "at" << product.address << ", it is not configured";
 }
 
-void BangOlufsen::Next() {
-    postRequest("/BeoZone/Zone/Stream/Forward", "");
-    postRequest("/BeoZone/Zone/Stream/Forward/Release", "");
-}
+void BangOlufsen::onDeviceConnectedChanged() {
+    if (m_state == DISCONNECTED) {
+        return;
+    }
 
-void BangOlufsen::Prev() {
-    postRequest("/BeoZone/Zone/Stream/Backward", "");
-    postRequest("/BeoZone/Zone/Stream/Backward/Release", "");
+    // the integration is connected as long as one product is reachable
+    for (BeoDevice *device : m_devices) {
+        if (device->isConnected()) {
+            setState(CONNECTED);
+            return;
+        }
+    }
+    setState(CONNECTING);
 }
 
-void BangOlufsen::Standby() {
-    QVariantMap data;
-    data.insert("powerState", "standby");
-    QVariantMap motherData;
-    motherData.insert("standby", data);
-    putRequest("/BeoDevice/powerManagement/standby", motherData);
-}
+void BangOlufsen::schedulePolling() {
+    if (m_state == DISCONNECTED || m_devices.isEmpty()) {
+        return;
+    }
 
-void BangOlufsen::TurnOn() {
-    QVariantMap data;
-    data.insert("powerState", "on");
-    QVariantMap motherData;
-    motherData.insert("standby", data);
-    putRequest("/BeoDevice/powerManagement/standby", motherData);
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (BeoDevice *device : m_devices) {
+        next = qMin(next, device->msecsToPoll());
+    }
+    m_pollingTimer->start(static_cast<int>(qMax<qint64>(0, next)));
 }
 
 void BangOlufsen::onPollingTimerTimeout() {
-    getStandby();
+    for (BeoDevice *device : m_devices) {
+        if (device->msecsToPoll() <= 0) {
+            device->poll();
+        }
+    }
+    schedulePolling();
 }
@@ -22,13 +22,21 @@
 
 #pragma once
 
+#include <QHash>
+#include <QList>
 #include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QObject>
 #include <QString>
 #include <QTimer>
 #include <QVariant>
 
+#include <functional>
+
+#include "artworkcache.h"
+#include "beodevice.h"
+#include "deviceprofile.h"
+#include "mdnsbrowser.h"
+#include "productdiscovery.h"
 #include "yio-plugin/integration.h"
 #include "yio-plugin/plugin.h"
 
@@ -68,8 +76,32 @@ class BangOlufsen : public Integration {
 
     void sendCommand(const QString& type, const QString& entityId, int command, const QVariant& param) override;
 
+    /// Runtime metrics of all products by entity id: request latency per endpoint, requests in flight, notification
+    /// rate per type, JSON parse cost and stream reconnects and uptime. "resources" counts the live objects and
+    /// network replies of the integration, they must stay flat over a long uptime.
+    Q_INVOKABLE QVariantMap metrics() const;
+
+    /// Playback position in seconds, extrapolated locally between the progress events of the product.
+    Q_INVOKABLE int position(const QString& entityId) const;
+
+    Q_INVOKABLE bool isStale(const QString& entityId) const;
+
+    /// While the player is not visible, notifications are filtered by the notification_filter policies.
+    Q_INVOKABLE void setUiVisible(bool visible);
+
+    /// Rate of the position updates of the entities while playing, e.g. while the progress bar is visible.
+    /// 0 only updates them on playback state changes and position jumps.
+    Q_INVOKABLE void setProgressInterval(int msecs);
+
+    /// Loads album art into the cache ahead of time, e.g. the cover of the next track.
+    Q_INVOKABLE void prefetchArtwork(const QString& url);
+
  signals:
-    void requestReady(const QVariantMap& obj, const QString& url);
+    void groupCommandFinished(const QString& entityId, int command, bool success);
+    /// The entity shows the state from before standby or a disconnect, until the product confirmed it.
+    void staleChanged(const QString& entityId, bool stale);
+    void sourcesLoaded(const QString& entityId, bool ok, const QVariantList& sources);
+    void contentLoaded(const QString& entityId, const QString& path, int offset, bool ok, const QVariantMap& page);
 
  public slots:
     void connect() override;
@@ -77,53 +109,57 @@ class BangOlufsen : public Integration {
     void enterStandby() override;
     void leaveStandby() override;
 
+    // multiroom (BeoLink), requests to several products are sent concurrently
+    void sendGroupCommand(const QString& entityId, int command, const QVariant& param);
+    void joinExperience(const QStringList& entityIds);
+    void leaveExperience(const QStringList& entityIds);
+
+    // source picker and content browsing, answered by sourcesLoaded and contentLoaded
+    void loadSources(const QString& entityId);
+    void browse(const QString& entityId, const QString& path, int offset = 0,
+                int count = ContentCache::DEFAULT_PAGE_SIZE);
+
  private:
-    void updateEntity(const QString& entity_id, const QVariantMap& map);
+    typedef std::function<void(BeoDevice* device, const BeoDevice::DoneCallback& done)> DeviceAction;
+
+    QList<BeoDevice*> groupMembers(BeoDevice* device) const;
+    QList<BeoDevice*> devicesByEntity(const QStringList& entityIds) const;
+    void              fanOut(const QList<BeoDevice*>& devices, const DeviceAction& action,
+                             const std::function<void(int failed)>& finished);
 
-    // get, post and put requests
-    void getRequest(const QString& url);
-    void postRequest(const QString& url, const QString& params);
-    void putRequest(const QString& url, const QVariantMap& params);
-    void putRequest(const QString& url);
+    void addDevice(const QString& ip, const QString& entityId, const QString& name);
 
-    QString m_ip;
-    QString m_baseUrl;
-    QString m_entityId;
+    QVariantMap resources() const;
 
+    // shared by all products
     QNetworkAccessManager* m_manager = nullptr;
-    QNetworkReply*         m_reply   = nullptr;
+    ArtworkCache*          m_artwork;
+    DeviceProfileStore*    m_profiles;
+
+    // request deadlines by priority in ms, 0 keeps the default of the client
+    int m_requestTimeouts[BeoHttpClient::BACKGROUND + 1];
+
+    QList<BeoDevice*>          m_devices;
+    QHash<QString, BeoDevice*> m_devicesByEntity;
+    QHash<BeoDevice*, QString> m_deviceNames;
+
+    // notification policies while the player is not visible, all types pass while it is
+    NotificationFilter::Policies m_hiddenPolicies;
+    bool                         m_uiVisible = true;
 
-    bool m_userDisconnect = false;
+    // follows products to new addresses, null if disabled
+    ProductDiscovery* m_discovery = nullptr;
 
     // polling
     QTimer* m_pollingTimer;
 
-    //    // get information from the speaker
-    int     getVolume(const QVariantMap& map);
-    bool    getMuted(const QVariantMap& map);
-    QString getSource(const QVariantMap& map);
-    //    void getSources();  // poll
-    QString     getState(const QVariantMap& map);
-    void        getStandby();  // poll
-    QVariantMap getMusicInfo(const QVariantMap& map);
-    int         getPosition(const QVariantMap& map);
-    int         getDuration(const QVariantMap& map);
-    //    void getPrimariyExperience();
-
-    //    // commands to the speaker
-    void setVolume(const int& volume);
-    void setMute(const bool& value);
-    void Play();
-    void Pause();
-    void Stop();
-    void Next();
-    void Prev();
-    void Standby();
-    void TurnOn();
-    //    void setSource(const QVariantMap& source);
-    //    void joinExperience();
-    //    void leaveExperience();
+    // logs the metrics every metrics_log_interval seconds
+    QTimer* m_metricsTimer;
 
  private slots:
+    void onDeviceConnectedChanged();
+    void onProductFound(const BeoProductInfo& product);
+    void schedulePolling();
     void onPollingTimerTimeout();
+    void logMetrics();
 };
@@ -0,0 +1,1018 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "beodevice.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QUrl>
+#include <QtDebug>
+
+#include "yio-interface/entities/mediaplayerinterface.h"
+
+// the address may carry its own port, e.g. for a local stand-in of the product
+static QString baseUrlForAddress(const QString &address) {
+    QUrl url(QString("http://").append(address));
+    if (url.port() == -1) {
+        url.setPort(BeoDevice::DEFAULT_PORT);
+    }
+    return url.toString(QUrl::StripTrailingSlash);
+}
+
+BeoDevice::BeoDevice(const QString &ip, const QString &entityId, QNetworkAccessManager *manager,
+                     ArtworkCache *artwork, EntitiesInterface *entities, const QLoggingCategory &logCategory,
+                     QObject *parent)
+    : QObject(parent),
+      m_ip(ip),
+      m_baseUrl(baseUrlForAddress(ip)),
+      m_entityId(entityId),
+      m_manager(manager),
+      m_artwork(artwork),
+      m_entities(entities),
+      m_logCategory(logCategory),
+      m_optimistic([this](int attribute) { return m_shadow.value(attribute); },
+                   [this](int attribute, const QVariant &value) { return m_shadow.set(attribute, value); }),
+      m_volumeSender([this](const QVariant &value, const CommandCoalescer::DoneCallback &done) {
+          QVariantMap data;
+          data.insert("level", value);
+          putRequest("/BeoZone/Zone/Sound/Volume/Speaker/Level", data, done);
+      }),
+      m_muteSender([this](const QVariant &value, const CommandCoalescer::DoneCallback &done) {
+          QVariantMap data;
+          data.insert("muted", value);
+          putRequest("/BeoZone/Zone/Sound/Volume/Speaker/Muted", data, done);
+      }) {
+    m_client = new BeoHttpClient(m_manager, m_baseUrl, this);
+    m_client->setMetrics(&m_metrics);
+    m_content = new ContentCache(m_client);
+    m_clock.start();
+
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    QObject::connect(m_reconnectTimer, &QTimer::timeout, this, &BeoDevice::openStream);
+
+    m_sampleTimer = new QTimer(this);
+    m_sampleTimer->setSingleShot(true);
+    QObject::connect(m_sampleTimer, &QTimer::timeout, this, [this]() {
+        m_filter.releaseDue([this](const QByteArray &frame) { onNotificationFrame(frame); });
+        scheduleSampledFrames();
+    });
+
+    m_streamWatchdog = new QTimer(this);
+    m_streamWatchdog->setSingleShot(true);
+    m_streamWatchdog->setInterval(STREAM_IDLE_TIMEOUT);
+    QObject::connect(m_streamWatchdog, &QTimer::timeout, this, &BeoDevice::onStreamIdle);
+
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(PROGRESS_INTERVAL_DEFAULT);
+    QObject::connect(m_progressTimer, &QTimer::timeout, this, &BeoDevice::pushPosition);
+
+    m_settleTimer = new QTimer(this);
+    m_settleTimer->setSingleShot(true);
+    QObject::connect(m_settleTimer, &QTimer::timeout, this, &BeoDevice::settleStates);
+}
+
+BeoDevice::~BeoDevice() {
+    closeStream();
+    delete m_content;
+}
+
+void BeoDevice::connectToDevice() {
+    if (m_connectionState != DISCONNECTED) {
+        return;
+    }
+
+    m_backoff.reset();
+
+    // the entity still shows the state from before the disconnect, query the current one while the stream opens
+    setStale(true);
+    resync();
+    openStream();
+}
+
+void BeoDevice::disconnectFromDevice() {
+    m_reconnectTimer->stop();
+    // the stream goes first, a cancelled poll must not be taken for a lost stream
+    closeStream();
+
+    // commands sent while the stream was down are cancelled as well, they must not run after a wake up.
+    // reset first, otherwise the cancelled requests would send the pending values
+    m_volumeSender.reset();
+    m_muteSender.reset();
+    m_client->cancelAll();
+    m_optimistic.clear();
+    m_settleTimer->stop();
+    if (m_connectionState == DISCONNECTED) {
+        return;
+    }
+
+    qCDebug(m_logCategory) << "Disconnecting a Bang & Olufsen product" << m_baseUrl;
+    m_progressTimer->stop();
+    m_playbackClock.clear();
+    setConnectionState(DISCONNECTED);
+}
+
+void BeoDevice::setRequestTimeout(BeoHttpClient::Priority priority, int msecs) {
+    m_client->setTimeout(priority, msecs);
+}
+
+void BeoDevice::reconnectNow() {
+    if (m_connectionState == RECONNECT_WAIT) {
+        m_reconnectTimer->stop();
+        m_backoff.reset();
+        openStream();
+    }
+}
+
+bool BeoDevice::setAddress(const QString &address) {
+    QString baseUrl = baseUrlForAddress(address);
+    if (baseUrl == m_baseUrl) {
+        return false;
+    }
+
+    qCInfo(m_logCategory) << "Bang & Olufsen product" << m_entityId << "moved from" << m_baseUrl << "to" << baseUrl;
+    m_ip = address;
+    m_baseUrl = baseUrl;
+    m_client->setBaseUrl(baseUrl);
+
+    bool reopen = m_connectionState != DISCONNECTED;
+    if (reopen) {
+        m_reconnectTimer->stop();
+        closeStream();
+    }
+    // requests in flight went to the old address
+    m_client->cancelAll();
+    if (reopen) {
+        m_backoff.reset();
+        openStream();
+    }
+    return true;
+}
+
+void BeoDevice::openStream() {
+    setConnectionState(CONNECTING);
+    qCDebug(m_logCategory) << "Connecting to a Bang & Olufsen product:" << m_baseUrl;
+
+    QNetworkRequest request;
+    request.setUrl(QUrl(m_baseUrl + "/BeoNotify/Notifications"));
+
+    // a new stream never continues a frame of the previous one
+    m_framer.clear();
+    m_filter.clear();
+
+    QNetworkReply *reply = m_manager->get(request);
+    m_reply = reply;
+    m_streamWatchdog->start();
+
+    // read the streaming json
+    QObject::connect(reply, &QIODevice::readyRead, this, [=]() {
+        if (reply != m_reply || reply->error()) {
+            return;
+        }
+        m_streamWatchdog->start();
+        setConnectionState(CONNECTED);
+        feedStream(reply->readAll());
+    });
+
+    // handle closed connection
+    QObject::connect(reply, &QNetworkReply::finished, this,
+                     [=]() { onStreamLost(reply, "Bang & Olufsen product dropped the connection"); });
+
+    // handle dropped connection
+    QObject::connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error), this,
+                     [=](QNetworkReply::NetworkError code) {
+                         Q_UNUSED(code)
+                         onStreamLost(reply, reply->errorString());
+                     });
+}
+
+void BeoDevice::feedStream(const QByteArray &data) {
+    // one read may carry many notifications, e.g. on a track skip, the entity only gets their merged result
+    m_shadow.hold();
+    if (!m_framer.feed(data, [this](const QByteArray &frame) { onStreamFrame(frame); })) {
+        qCWarning(m_logCategory) << "Notification exceeded the buffer limit, dropping pending data";
+    }
+    m_shadow.release();
+}
+
+void BeoDevice::onStreamFrame(const QByteArray &frame) {
+    // the filter decides before the frame is decoded, a frame without a recognizable type is always decoded
+    BeoNotification::Type type;
+    if (NotificationDecoder::peekType(frame, &type) &&
+        (type == BeoNotification::UNKNOWN || !m_filter.accept(type, frame))) {
+        m_metrics.recordFiltered(type);
+        onFilteredFrame(type, frame);
+        scheduleSampledFrames();
+        return;
+    }
+    onNotificationFrame(frame);
+}
+
+void BeoDevice::scheduleSampledFrames() {
+    qint64 msecs = m_filter.msecsToRelease();
+    if (msecs >= 0 && !m_sampleTimer->isActive()) {
+        m_sampleTimer->start(static_cast<int>(msecs));
+    }
+}
+
+void BeoDevice::onFilteredFrame(BeoNotification::Type type, const QByteArray &frame) {
+    // the entity update is held back, but relative volume commands and pending command effects still follow the
+    // product, otherwise a volume key would start from an old level and a confirmed command would roll back
+    if (type != BeoNotification::VOLUME &&
+        !(type == BeoNotification::PROGRESS_INFORMATION && m_optimistic.isPending(MediaPlayerDef::STATE))) {
+        return;
+    }
+
+    BeoNotification notification;
+    if (!NotificationDecoder::decode(frame, &notification)) {
+        return;
+    }
+    if (notification.type == BeoNotification::VOLUME) {
+        trackVolume(notification.volume);
+    }
+    confirmStates(notification);
+}
+
+void BeoDevice::setNotificationPolicies(const NotificationFilter::Policies &policies) {
+    m_filter.setPolicies(policies, [this](const QByteArray &frame) { onNotificationFrame(frame); });
+}
+
+void BeoDevice::closeStream() {
+    m_streamWatchdog->stop();
+    m_sampleTimer->stop();
+    if (m_reply != nullptr) {
+        m_reply->disconnect(this);
+        m_reply->abort();
+        m_reply->deleteLater();
+        m_reply = nullptr;
+    }
+}
+
+void BeoDevice::onStreamLost(QNetworkReply *reply, const QString &reason) {
+    // error and finished are both emitted for one failure, only the first one schedules a reconnect
+    if (reply != m_reply) {
+        return;
+    }
+    closeStream();
+    m_metrics.recordReconnect();
+
+    int delay = m_backoff.nextDelay();
+    qCDebug(m_logCategory) << reason << m_baseUrl << "- reconnecting in" << delay << "ms, attempt"
+                           << m_backoff.attempts();
+    setConnectionState(RECONNECT_WAIT);
+    m_reconnectTimer->start(delay);
+
+    if (m_backoff.attempts() == UNREACHABLE_ATTEMPTS) {
+        qCWarning(m_logCategory) << "Bang & Olufsen product" << m_entityId << "unreachable at" << m_baseUrl;
+        emit unreachable();
+    }
+}
+
+void BeoDevice::onStreamIdle() {
+    QNetworkReply *reply = m_reply;
+    if (reply == nullptr) {
+        return;
+    }
+    if (m_connectionState != CONNECTED) {
+        onStreamLost(reply, "Bang & Olufsen product did not start the notification stream");
+        return;
+    }
+
+    // a quiet stream is normal while nothing plays, but the product must still answer
+    getStandby([=](bool success) {
+        if (reply != m_reply) {
+            return;
+        }
+        if (success) {
+            m_streamWatchdog->start();
+        } else {
+            onStreamLost(reply, "Bang & Olufsen product stopped answering");
+        }
+    });
+}
+
+void BeoDevice::setConnectionState(ConnectionState state) {
+    if (state == m_connectionState) {
+        return;
+    }
+
+    bool wasConnected = m_connectionState == CONNECTED;
+    m_connectionState = state;
+    m_metrics.setStreamConnected(state == CONNECTED);
+
+    if (state == CONNECTED) {
+        m_backoff.reset();
+        // changes may have been missed while the stream was down
+        m_content->invalidate();
+        // the stream only reports changes. The current state is queried unless a resync started with the connect
+        // is still on its way or already confirmed it, only a failed or missing one is repeated.
+        if (m_stale && m_resyncPending == 0) {
+            resync();
+        }
+        // tells whether the product was replaced or updated since it was probed
+        getDeviceInfo();
+        emit connectedChanged(true);
+    } else if (wasConnected) {
+        // changes are missed until the stream is back
+        setStale(true);
+        // without the stream the power state is only known from polling
+        tightenPolling();
+        emit connectedChanged(false);
+    }
+}
+
+void BeoDevice::resync() {
+    m_resyncPending = 2;
+    m_resyncFailed = false;
+
+    // every answer is written when it arrives, the shadow skips the values that did not change meanwhile.
+    // Holding the entity until both are in would also hold back the stream for a whole network round trip.
+    auto answered = [=](bool success) {
+        m_resyncFailed = m_resyncFailed || !success;
+        if (--m_resyncPending == 0) {
+            if (!m_resyncFailed) {
+                setStale(false);
+            }
+        }
+    };
+
+    getPrimaryExperience(answered);
+    getRequest(
+        "/BeoZone/Zone/Sound/Volume",
+        [=](const QJsonObject &object) {
+            BeoNotification notification;
+            notification.type = BeoNotification::VOLUME;
+            NotificationDecoder::decodeVolume(object.value("volume").toObject(), &notification.volume);
+            trackVolume(notification.volume);
+            updateEntity(notification);
+        },
+        answered);
+}
+
+void BeoDevice::setStale(bool stale) {
+    if (stale != m_stale) {
+        m_stale = stale;
+        emit staleChanged(stale);
+    }
+}
+
+void BeoDevice::trackVolume(const BeoVolume &volume) {
+    // base for relative volume and mute toggle commands
+    if (volume.level != -1) {
+        m_volume = volume.level;
+    }
+    m_muted = volume.muted;
+}
+
+void BeoDevice::getDeviceInfo() {
+    getRequest(
+        "/BeoDevice",
+        [=](const QJsonObject &object) {
+            const QJsonObject device = object.value("beoDevice").toObject();
+            m_serialNumber = device.value("productId").toObject().value("serialNumber").toString();
+            QString firmware = device.value("software").toObject().value("version").toString();
+            if (!m_serialNumber.isEmpty() && !m_profile.matches(m_serialNumber, firmware)) {
+                probeProfile(m_serialNumber, firmware);
+            }
+        },
+        DoneCallback(), BeoHttpClient::BACKGROUND);
+}
+
+void BeoDevice::setProfile(const BeoDeviceProfile &profile) {
+    m_profile = profile;
+    // identifies the product for discovery before it was reached in this run
+    if (m_serialNumber.isEmpty()) {
+        m_serialNumber = profile.serialNumber;
+    }
+}
+
+void BeoDevice::probeProfile(const QString &serialNumber, const QString &firmware) {
+    qCDebug(m_logCategory) << "Probing the capabilities of Bang & Olufsen product" << serialNumber << firmware;
+    getRequest(
+        "/BeoZone/Zone",
+        [=](const QJsonObject &object) {
+            const QJsonObject zone = object.value("zone").toObject();
+            getSources([=](bool ok, const QVariantList &sources) {
+                if (!ok) {
+                    return;
+                }
+                BeoDeviceProfile profile;
+                profile.serialNumber = serialNumber;
+                profile.firmware = firmware;
+                for (const QVariant &source : sources) {
+                    profile.sources.append(source.toMap().value("id").toString());
+                }
+                profile.features = BeoDeviceProfile::featuresFromZone(zone, !profile.sources.isEmpty());
+                if (profile.features.isEmpty()) {
+                    qCWarning(m_logCategory) << "Bang & Olufsen product" << serialNumber << "did not report its zone";
+                    return;
+                }
+                m_profile = profile;
+                emit profileChanged();
+            });
+        },
+        DoneCallback(), BeoHttpClient::BACKGROUND);
+}
+
+QVariantMap BeoDevice::metrics() const {
+    static const char *const CONNECTION_STATES[] = {"DISCONNECTED", "CONNECTING", "CONNECTED", "RECONNECT_WAIT"};
+
+    QVariantMap map = m_metrics.toVariantMap();
+    map.insert("connection", CONNECTION_STATES[m_connectionState]);
+    map.insert("in_flight", m_client->inFlightCount());
+    map.insert("queued", m_client->queuedCount());
+    return map;
+}
+
+int BeoDevice::position() const {
+    return static_cast<int>(m_playbackClock.position(m_clock.elapsed()) / 1000);
+}
+
+void BeoDevice::setProgressInterval(int msecs) {
+    if (msecs <= 0) {
+        m_progressTimer->stop();
+        m_progressTimer->setInterval(0);
+        return;
+    }
+
+    m_progressTimer->setInterval(msecs);
+    if (m_playbackClock.isPlaying()) {
+        m_progressTimer->start();
+    }
+}
+
+void BeoDevice::setStreamIdleTimeout(int msecs) {
+    // applies from the next data on the stream
+    m_streamWatchdog->setInterval(msecs > 0 ? msecs : STREAM_IDLE_TIMEOUT);
+}
+
+qint64 BeoDevice::msecsToPoll() const {
+    return m_nextPoll - m_clock.elapsed();
+}
+
+void BeoDevice::poll() {
+    QNetworkReply *reply = m_reply;
+    getStandby([=](bool success) {
+        if (success) {
+            // the product answers again, e.g. the network is back, the backoff need not be waited for
+            reconnectNow();
+        } else if (reply != nullptr && reply == m_reply && isConnected()) {
+            // the stream looks healthy, but the product is gone
+            onStreamLost(reply, "Bang & Olufsen product did not answer the standby poll");
+        }
+    });
+
+    // while the stream delivers the power state, the poll is only a safety net and can back off
+    if (isConnected()) {
+        m_pollInterval = qMin(m_pollInterval * 2, static_cast<int>(POLL_INTERVAL_MAX));
+    } else {
+        m_pollInterval = POLL_INTERVAL_DEFAULT;
+    }
+    m_nextPoll = m_clock.elapsed() + m_pollInterval;
+}
+
+void BeoDevice::resetPolling() {
+    m_pollInterval = POLL_INTERVAL_DEFAULT;
+    m_nextPoll = m_clock.elapsed();
+    emit pollScheduleChanged();
+}
+
+void BeoDevice::tightenPolling() {
+    m_pollInterval = POLL_INTERVAL_MIN;
+    m_nextPoll = qMin(m_nextPoll, m_clock.elapsed() + POLL_INTERVAL_MIN);
+    emit pollScheduleChanged();
+}
+
+void BeoDevice::sendCommand(int command, const QVariant &param, const DoneCallback &done) {
+    // commands may change the power state, check it again soon
+    tightenPolling();
+
+    if (command == MediaPlayerDef::C_VOLUME_SET) {
+        setVolume(param.toInt(), done);
+    } else if (command == MediaPlayerDef::C_VOLUME_UP) {
+        changeVolume(VOLUME_STEP, done);
+    } else if (command == MediaPlayerDef::C_VOLUME_DOWN) {
+        changeVolume(-VOLUME_STEP, done);
+    } else if (command == MediaPlayerDef::C_PLAY) {
+        Play(done);
+    } else if (command == MediaPlayerDef::C_MUTE) {
+        // toggle the state shown on the entity, not the one of a command still on its way
+        QVariant target = m_optimistic.pendingValue(MediaPlayerDef::MUTED);
+        if (!target.isValid()) {
+            target = m_muteSender.targetValue();
+        }
+        setMute(!(target.isValid() ? target.toBool() : m_muted), done);
+    } else if (command == MediaPlayerDef::C_PAUSE) {
+        Pause(done);
+    } else if (command == MediaPlayerDef::C_STOP) {
+        Stop(done);
+    } else if (command == MediaPlayerDef::C_PREVIOUS) {
+        Prev(done);
+    } else if (command == MediaPlayerDef::C_NEXT) {
+        Next(done);
+    } else if (command == MediaPlayerDef::C_TURNON) {
+        TurnOn(done);
+    } else if (command == MediaPlayerDef::C_TURNOFF) {
+        Standby(done);
+    } else if (done) {
+        done(false);
+    }
+}
+
+void BeoDevice::attachEntity(const EntityShadow::SupportedFunction &isSupported,
+                             const EntityShadow::UpdateFunction &update) {
+    m_shadow.attach(isSupported, update);
+}
+
+bool BeoDevice::attachEntity() {
+    if (!m_shadow.isAttached() && m_entities != nullptr) {
+        m_shadow.attach(m_entities->getEntityInterface(m_entityId));
+    }
+    return m_shadow.isAttached();
+}
+
+void BeoDevice::setPowerState(bool on) {
+    if (!attachEntity() || !m_shadow.supports(MediaPlayerDef::F_TURN_ON) ||
+        !m_shadow.supports(MediaPlayerDef::F_TURN_OFF)) {
+        return;
+    }
+
+    if (on) {
+        // the device is on, keep a playing or idle state reported by the stream
+        QVariant state = m_shadow.value(MediaPlayerDef::STATE);
+        if (!state.isValid() || state.toInt() == MediaPlayerDef::OFF) {
+            reportState(MediaPlayerDef::STATE, MediaPlayerDef::ON);
+        }
+    } else {
+        reportState(MediaPlayerDef::STATE, MediaPlayerDef::OFF);
+    }
+}
+
+void BeoDevice::updateEntity(const BeoNotification &notification) {
+    if (!attachEntity()) {
+        return;
+    }
+
+    // only the attributes carried by the notification are written, unchanged values are skipped by the shadow
+    switch (notification.type) {
+        case BeoNotification::PROGRESS_INFORMATION:
+            if (notification.progress.state == BeoProgress::PLAY) {
+                reportState(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
+            } else if (notification.progress.state == BeoProgress::PAUSE ||
+                       notification.progress.state == BeoProgress::STOP) {
+                reportState(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
+            }
+
+            // media duration
+            if (m_shadow.supports(MediaPlayerDef::F_MEDIA_DURATION)) {
+                m_shadow.set(MediaPlayerDef::MEDIADURATION, notification.progress.duration);
+            }
+
+            updatePlaybackClock(notification.progress);
+            break;
+
+        case BeoNotification::SOURCE:
+            if (m_shadow.supports(MediaPlayerDef::F_SOURCE) && !notification.source.friendlyName.isEmpty()) {
+                m_shadow.set(MediaPlayerDef::SOURCE, notification.source.friendlyName);
+            }
+            break;
+
+        case BeoNotification::VOLUME:
+            if (m_shadow.supports(MediaPlayerDef::F_VOLUME_SET) && notification.volume.level != -1) {
+                reportState(MediaPlayerDef::VOLUME, notification.volume.level);
+            }
+            if (m_shadow.supports(MediaPlayerDef::F_MUTE_SET) && m_shadow.supports(MediaPlayerDef::F_MUTE)) {
+                reportState(MediaPlayerDef::MUTED, notification.volume.muted);
+            }
+            break;
+
+        case BeoNotification::SHUTDOWN:
+        case BeoNotification::STANDBY:
+            setPowerState(notification.power.on);
+            break;
+
+        case BeoNotification::NOW_PLAYING_STORED_MUSIC:
+        case BeoNotification::NOW_PLAYING_NET_RADIO:
+            // media image
+            if (m_shadow.supports(MediaPlayerDef::F_MEDIA_IMAGE) && !notification.music.imageUrl.isEmpty()) {
+                updateImage(notification.music.imageUrl);
+            }
+
+            // media title
+            if (m_shadow.supports(MediaPlayerDef::F_MEDIA_TITLE)) {
+                m_shadow.set(MediaPlayerDef::MEDIATITLE, notification.music.title);
+            }
+
+            // media artist
+            if (m_shadow.supports(MediaPlayerDef::F_MEDIA_ARTIST)) {
+                m_shadow.set(MediaPlayerDef::MEDIAARTIST, notification.music.artist);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void BeoDevice::confirmStates(const BeoNotification &notification) {
+    // only the attributes with a command effect pending, a confirmation does not change what the entity shows
+    switch (notification.type) {
+        case BeoNotification::VOLUME:
+            if (m_optimistic.isPending(MediaPlayerDef::VOLUME) && notification.volume.level != -1) {
+                reportState(MediaPlayerDef::VOLUME, notification.volume.level);
+            }
+            if (m_optimistic.isPending(MediaPlayerDef::MUTED)) {
+                reportState(MediaPlayerDef::MUTED, notification.volume.muted);
+            }
+            break;
+
+        case BeoNotification::PROGRESS_INFORMATION:
+            if (!m_optimistic.isPending(MediaPlayerDef::STATE)) {
+                break;
+            }
+            if (notification.progress.state == BeoProgress::PLAY) {
+                reportState(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING);
+            } else if (notification.progress.state == BeoProgress::PAUSE ||
+                       notification.progress.state == BeoProgress::STOP) {
+                reportState(MediaPlayerDef::STATE, MediaPlayerDef::IDLE);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void BeoDevice::reportState(int attribute, const QVariant &value) {
+    // a pending command effect stays on the entity until the product confirms it or it settles
+    m_optimistic.report(attribute, value);
+}
+
+BeoDevice::DoneCallback BeoDevice::proposeState(int attribute, const QVariant &value, const DoneCallback &done) {
+    if (!attachEntity()) {
+        return done;
+    }
+    m_optimistic.propose(attribute, value);
+
+    QPointer<BeoDevice> self(this);
+    return [self, attribute, done](bool success) {
+        if (self) {
+            self->m_optimistic.commandDone(attribute, success, self->m_clock.elapsed());
+            self->settleStates();
+        }
+        if (done) {
+            done(success);
+        }
+    };
+}
+
+void BeoDevice::settleStates() {
+    qint64 next = m_optimistic.settle(m_clock.elapsed());
+    if (next >= 0) {
+        m_settleTimer->start(static_cast<int>(next));
+    }
+}
+
+void BeoDevice::updatePlaybackClock(const BeoProgress &progress) {
+    qint64 now = m_clock.elapsed();
+    bool   wasValid = m_playbackClock.isValid();
+    bool   wasPlaying = m_playbackClock.isPlaying();
+    qint64 expected = m_playbackClock.position(now);
+
+    qint64 position = static_cast<qint64>(progress.position) * 1000;
+    bool   playing = progress.state == BeoProgress::PLAY;
+    m_playbackClock.anchor(position, static_cast<qint64>(progress.duration) * 1000, playing, now);
+
+    // a progress event arrives every second while playing, the clock only needs correcting if it drifted
+    if (!wasValid || playing != wasPlaying || qAbs(position - expected) > POSITION_DRIFT_TOLERANCE) {
+        pushPosition();
+    }
+
+    if (playing && m_progressTimer->interval() > 0) {
+        if (!m_progressTimer->isActive()) {
+            m_progressTimer->start();
+        }
+    } else {
+        m_progressTimer->stop();
+    }
+}
+
+void BeoDevice::pushPosition() {
+    if (attachEntity() && m_shadow.supports(MediaPlayerDef::F_MEDIA_POSITION)) {
+        m_shadow.set(MediaPlayerDef::MEDIAPROGRESS, position());
+    }
+}
+
+void BeoDevice::updateImage(const QString &url) {
+    if (url == m_imageUrl) {
+        return;
+    }
+    m_imageUrl = url;
+    if (m_artwork == nullptr) {
+        m_shadow.set(MediaPlayerDef::MEDIAIMAGE, url);
+        return;
+    }
+
+    QPointer<BeoDevice> self(this);
+    m_artwork->request(url, [=](const QString &localUrl) {
+        // the product may be gone or already play the next track
+        if (!self || m_imageUrl != url) {
+            return;
+        }
+        m_shadow.set(MediaPlayerDef::MEDIAIMAGE, localUrl.isEmpty() ? url : localUrl);
+    });
+}
+
+void BeoDevice::onNotificationFrame(const QByteArray &frame) {
+    BeoNotification notification;
+    QString         errorString;
+    QElapsedTimer   parseTimer;
+    parseTimer.start();
+    if (!NotificationDecoder::decode(frame, &notification, &errorString)) {
+        m_metrics.recordParseFailure(parseTimer.nsecsElapsed());
+        // skip the broken frame only, the following ones are still valid
+        qCWarning(m_logCategory) << "JSON error : " << errorString;
+        return;
+    }
+    m_metrics.recordNotification(notification.type, parseTimer.nsecsElapsed());
+
+    if (notification.type == BeoNotification::VOLUME) {
+        trackVolume(notification.volume);
+    }
+
+    if (notification.type == BeoNotification::SOURCE) {
+        setExperience(notification.source);
+        // the list tells which sources are in use
+        m_content->invalidate("/BeoZone/Zone/Sources");
+    }
+
+    // a product in standby does not report volume, sources or music, so these events mean it is on
+    if (notification.type == BeoNotification::VOLUME ||
+        notification.type == BeoNotification::NOW_PLAYING_STORED_MUSIC ||
+        notification.type == BeoNotification::NOW_PLAYING_NET_RADIO ||
+        (notification.type == BeoNotification::SOURCE && !notification.source.id.isEmpty())) {
+        setPowerState(true);
+    }
+
+    if (notification.type != BeoNotification::UNKNOWN) {
+        updateEntity(notification);
+    }
+}
+
+void BeoDevice::getRequest(const QString &url, const JsonHandler &handler, const DoneCallback &done,
+                           BeoHttpClient::Priority priority) {
+    BeoHttpClient::Options options;
+    options.priority = priority;
+
+    m_client->send(QNetworkAccessManager::GetOperation, url, QByteArray(), options, [=](const BeoResponse &response) {
+        if (!response.isOk()) {
+            qCWarning(m_logCategory) << "GET REQUEST" << url << BeoResponse::statusName(response.status)
+                                     << response.errorString;
+            if (done) {
+                done(false);
+            }
+            return;
+        }
+
+        QJsonObject object;
+        QString     errorString;
+        if (!response.parseJson(&object, &errorString)) {
+            qCWarning(m_logCategory) << "JSON error : " << errorString;
+            if (done) {
+                done(false);
+            }
+            return;
+        }
+        handler(object);
+        if (done) {
+            done(true);
+        }
+    });
+}
+
+void BeoDevice::commandRequest(QNetworkAccessManager::Operation operation, const QString &url,
+                               const QByteArray &body, const DoneCallback &done, const QString &orderKey) {
+    // user commands go ahead of polling and background queries
+    BeoHttpClient::Options options;
+    options.priority = BeoHttpClient::INTERACTIVE;
+    options.orderKey = orderKey;
+
+    m_client->send(operation, url, body, options, [=](const BeoResponse &response) {
+        if (response.isOk()) {
+            qCDebug(m_logCategory) << "REQUEST" << url << response.httpStatus << response.body;
+        } else {
+            qCWarning(m_logCategory) << "REQUEST" << url << BeoResponse::statusName(response.status)
+                                     << response.httpStatus << response.errorString;
+        }
+        if (done) {
+            done(response.isOk());
+        }
+    });
+}
+
+void BeoDevice::postRequest(const QString &url, const QString &params, const DoneCallback &done) {
+    commandRequest(QNetworkAccessManager::PostOperation, url + params, QByteArray(), done);
+}
+
+void BeoDevice::postRequest(const QString &url, const QVariantMap &params, const DoneCallback &done) {
+    QByteArray data = QJsonDocument::fromVariant(params).toJson(QJsonDocument::JsonFormat::Compact);
+    commandRequest(QNetworkAccessManager::PostOperation, url, data, done);
+}
+
+void BeoDevice::putRequest(const QString &url, const QVariantMap &params, const DoneCallback &done) {
+    QByteArray data = QJsonDocument::fromVariant(params).toJson(QJsonDocument::JsonFormat::Compact);
+    commandRequest(QNetworkAccessManager::PutOperation, url, data, done);
+}
+
+void BeoDevice::putRequest(const QString &url) {
+    putRequest(url, QVariantMap());
+}
+
+void BeoDevice::deleteRequest(const QString &url, const DoneCallback &done) {
+    commandRequest(QNetworkAccessManager::DeleteOperation, url, QByteArray(), done);
+}
+
+void BeoDevice::getStandby(const DoneCallback &done) {
+    getRequest(
+        "/BeoDevice/powerManagement/standby",
+        [=](const QJsonObject &object) {
+            setPowerState(object.value("standby").toObject().value("powerState").toString() == "on");
+        },
+        done, BeoHttpClient::BACKGROUND);
+}
+
+bool BeoDevice::isGroupedWith(const BeoDevice *other) const {
+    return m_experience.isGroupedWith(other->m_experience);
+}
+
+void BeoDevice::getPrimaryExperience(const DoneCallback &done) {
+    getRequest(
+        "/BeoZone/Zone/ActiveSources",
+        [=](const QJsonObject &object) {
+            BeoSource experience;
+            NotificationDecoder::decodePrimaryExperience(
+                object.value("activeSources").toObject().value("primaryExperience").toObject(), &experience);
+            setExperience(experience);
+        },
+        done);
+}
+
+void BeoDevice::setExperience(const BeoSource &experience) {
+    bool changed = experience.id != m_experience.id || experience.productJid != m_experience.productJid ||
+                   experience.listeners != m_experience.listeners;
+    m_experience = experience;
+    if (changed) {
+        qCDebug(m_logCategory) << "Primary experience of" << m_baseUrl << ":" << experience.id << experience.productName
+                               << experience.listeners;
+        emit experienceChanged();
+    }
+}
+
+void BeoDevice::getSources(const SourcesHandler &handler) {
+    m_content->fetch("/BeoZone/Zone/Sources", 0, 0, [=](bool ok, const QJsonObject &page) {
+        QVariantList sources;
+        // the sources are a list of [id, source] pairs
+        const QJsonArray entries = page.value("sources").toArray();
+        for (const QJsonValue &entry : entries) {
+            QJsonObject source = entry.isArray() ? entry.toArray().at(1).toObject() : entry.toObject();
+
+            QVariantMap map;
+            map.insert("id", source.value("id").toString());
+            map.insert("friendlyName", source.value("friendlyName").toString());
+            map.insert("category", source.value("category").toString());
+            map.insert("inUse", source.value("inUse").toBool());
+            sources.append(map);
+        }
+        handler(ok, sources);
+    });
+}
+
+void BeoDevice::browse(const QString &path, int offset, int count, const ContentCache::PageHandler &handler) {
+    m_content->fetch(path, offset, count, handler);
+}
+
+void BeoDevice::setSource(const QString &sourceId, const DoneCallback &done) {
+    QVariantMap source;
+    source.insert("id", sourceId);
+    QVariantMap primaryExperience;
+    primaryExperience.insert("source", source);
+    QVariantMap motherData;
+    motherData.insert("primaryExperience", primaryExperience);
+    postRequest("/BeoZone/Zone/ActiveSources", motherData, done);
+}
+
+void BeoDevice::joinExperience(const DoneCallback &done) {
+    postRequest("/BeoZone/Zone/Device/OneWayJoin", "", [=](bool success) {
+        // a failed or cancelled request left the experience as it was
+        if (success) {
+            getPrimaryExperience();
+        }
+        if (done) {
+            done(success);
+        }
+    });
+}
+
+void BeoDevice::leaveExperience(const DoneCallback &done) {
+    deleteRequest("/BeoZone/Zone/ActiveSources/primaryExperience", [=](bool success) {
+        // a failed or cancelled request left the experience as it was
+        if (success) {
+            getPrimaryExperience();
+        }
+        if (done) {
+            done(success);
+        }
+    });
+}
+
+void BeoDevice::setVolume(const int &volume, const DoneCallback &done) {
+    // only the newest value is sent while a volume request is running, e.g. when dragging the slider
+    int level = qBound(0, volume, 100);
+    m_volumeSender.submit(level, proposeState(MediaPlayerDef::VOLUME, level, done));
+}
+
+void BeoDevice::changeVolume(int delta, const DoneCallback &done) {
+    // continue from the level shown on the entity, so repeated presses add up before the speaker reports back
+    QVariant target = m_optimistic.pendingValue(MediaPlayerDef::VOLUME);
+    if (!target.isValid()) {
+        target = m_volumeSender.targetValue();
+    }
+    setVolume((target.isValid() ? target.toInt() : m_volume) + delta, done);
+}
+
+void BeoDevice::setMute(const bool &value, const DoneCallback &done) {
+    m_muteSender.submit(value, proposeState(MediaPlayerDef::MUTED, value, done));
+}
+
+void BeoDevice::pressAndRelease(const QString &url, const DoneCallback &done) {
+    // the release is only sent once the press was answered. It is sent after a failed press as well, so the button is
+    // never left pressed, but the command only succeeded if both were accepted.
+    QSharedPointer<bool> pressed(new bool(false));
+    commandRequest(QNetworkAccessManager::PostOperation, url, QByteArray(),
+                   [pressed](bool success) { *pressed = success; }, url);
+    commandRequest(QNetworkAccessManager::PostOperation, url + "/Release", QByteArray(),
+                   [pressed, done](bool success) {
+                       if (done) {
+                           done(*pressed && success);
+                       }
+                   },
+                   url);
+}
+
+void BeoDevice::Play(const DoneCallback &done) {
+    pressAndRelease("/BeoZone/Zone/Stream/Play", proposeState(MediaPlayerDef::STATE, MediaPlayerDef::PLAYING, done));
+}
+
+void BeoDevice::Pause(const DoneCallback &done) {
+    pressAndRelease("/BeoZone/Zone/Stream/Pause", proposeState(MediaPlayerDef::STATE, MediaPlayerDef::IDLE, done));
+}
+
+void BeoDevice::Stop(const DoneCallback &done) {
+    pressAndRelease("/BeoZone/Zone/Stream/Stop", proposeState(MediaPlayerDef::STATE, MediaPlayerDef::IDLE, done));
+}
+
+void BeoDevice::Next(const DoneCallback &done) {
+    pressAndRelease("/BeoZone/Zone/Stream/Forward", done);
+}
+
+void BeoDevice::Prev(const DoneCallback &done) {
+    pressAndRelease("/BeoZone/Zone/Stream/Backward", done);
+}
+
+void BeoDevice::Standby(const DoneCallback &done) {
+    QVariantMap data;
+    data.insert("powerState", "standby");
+    QVariantMap motherData;
+    motherData.insert("standby", data);
+    putRequest("/BeoDevice/powerManagement/standby", motherData, done);
+}
+
+void BeoDevice::TurnOn(const DoneCallback &done) {
+    QVariantMap data;
+    data.insert("powerState", "on");
+    QVariantMap motherData;
+    motherData.insert("standby", data);
+    putRequest("/BeoDevice/powerManagement/standby", motherData, done);
+}
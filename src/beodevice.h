@@ -0,0 +1,286 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariant>
+
+#include <functional>
+
+#include "artworkcache.h"
+#include "beohttpclient.h"
+#include "beometrics.h"
+#include "commandcoalescer.h"
+#include "contentcache.h"
+#include "deviceprofile.h"
+#include "entityshadow.h"
+#include "notificationdecoder.h"
+#include "notificationfilter.h"
+#include "notificationframer.h"
+#include "optimisticstate.h"
+#include "playbackclock.h"
+#include "reconnectbackoff.h"
+#include "yio-interface/entities/entitiesinterface.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// BANG&OLUFSEN DEVICE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// One Bang & Olufsen product and its media player entity.
+/// Owns the notification stream of the product. The network access manager is shared by all devices.
+class BeoDevice : public QObject {
+    Q_OBJECT
+
+ public:
+    /// Called when a command was answered by the product.
+    typedef std::function<void(bool success)> DoneCallback;
+
+    /// Called with the sources of the product, each one a map with id, friendlyName, category and inUse.
+    typedef std::function<void(bool ok, const QVariantList& sources)> SourcesHandler;
+
+    /// RECONNECT_WAIT: the stream was lost and a reconnect is scheduled.
+    enum ConnectionState { DISCONNECTED, CONNECTING, CONNECTED, RECONNECT_WAIT };
+
+    /// Port of the REST API, used if the configured address has none.
+    static const int DEFAULT_PORT = 8080;
+
+    /// Without entities the product is followed but no entity is updated, unless one is attached with functions.
+    /// Without artwork the images are shown from their original URL.
+    BeoDevice(const QString& ip, const QString& entityId, QNetworkAccessManager* manager, ArtworkCache* artwork,
+              EntitiesInterface* entities, const QLoggingCategory& logCategory, QObject* parent = nullptr);
+
+    ~BeoDevice() override;
+
+    const QString&  ip() const { return m_ip; }
+    const QString&  baseUrl() const { return m_baseUrl; }
+    const QString&  entityId() const { return m_entityId; }
+    const QString&  serialNumber() const { return m_serialNumber; }
+    ConnectionState connectionState() const { return m_connectionState; }
+    bool            isConnected() const { return m_connectionState == CONNECTED; }
+
+    /// Capabilities of the product, stored from a previous run until it was probed. Invalid if never probed.
+    const BeoDeviceProfile& profile() const { return m_profile; }
+    void                    setProfile(const BeoDeviceProfile& profile);
+
+    /// The entity shows the state from before the last disconnect, it was not confirmed by the product yet.
+    bool isStale() const { return m_stale; }
+
+    void connectToDevice();
+
+    /// Closes the stream and cancels all requests, also the ones sent while the product was not connected.
+    void disconnectFromDevice();
+
+    /// Deadline of the requests of a priority: commands, state queries and background queries.
+    void setRequestTimeout(BeoHttpClient::Priority priority, int msecs);
+
+    /// Skips the backoff delay of a scheduled reconnect, e.g. when the product answered a poll or a discovery probe.
+    void reconnectNow();
+
+    /// Moves to a new address, e.g. found by discovery after DHCP assigned another one. An open stream is reopened.
+    /// Returns false if the address did not change.
+    bool setAddress(const QString& address);
+
+    void sendCommand(int command, const QVariant& param, const DoneCallback& done = DoneCallback());
+
+    /// Processes raw bytes of the notification stream, from framing to the entity update.
+    /// Called for the network stream, it can also be fed with recorded traces.
+    void feedStream(const QByteArray& data);
+
+    /// Writes the entity through these functions instead of the entity of the remote, e.g. in benchmarks.
+    void attachEntity(const EntityShadow::SupportedFunction& isSupported, const EntityShadow::UpdateFunction& update);
+
+    /// Policies of the notification types, e.g. to hold back progress events while the player is not visible.
+    void setNotificationPolicies(const NotificationFilter::Policies& policies);
+
+    /// Runtime metrics of the product, including the requests in flight and the connection state.
+    QVariantMap metrics() const;
+
+    /// Playback position in seconds, extrapolated from the last progress event while playing.
+    int position() const;
+
+    /// Rate of the position updates of the entity while playing. With 0 the entity is only updated when the
+    /// playback state changes or the product reports a position that drifted from the local clock.
+    void setProgressInterval(int msecs);
+
+    /// Time without data on the stream before the product is asked whether it is still there, with 0 the default.
+    void setStreamIdleTimeout(int msecs);
+
+    // power state polling, only a fallback to the notification stream
+    qint64 msecsToPoll() const;
+    void   poll();
+    void   resetPolling();
+
+    // sources and content browsing, cached and loaded in pages
+    void getSources(const SourcesHandler& handler);
+    void browse(const QString& path, int offset, int count, const ContentCache::PageHandler& handler);
+
+    // multiroom (BeoLink)
+    const BeoSource& experience() const { return m_experience; }
+    bool             isGroupedWith(const BeoDevice* other) const;
+    void             getPrimaryExperience(const DoneCallback& done = DoneCallback());
+    void             setSource(const QString& sourceId, const DoneCallback& done = DoneCallback());
+    void             joinExperience(const DoneCallback& done = DoneCallback());
+    void             leaveExperience(const DoneCallback& done = DoneCallback());
+
+ signals:
+    void connectedChanged(bool connected);
+    void experienceChanged();
+    void pollScheduleChanged();
+
+    void staleChanged(bool stale);
+
+    /// The product was probed, it is new or its firmware changed.
+    void profileChanged();
+
+    /// The stream could not be opened several times in a row, the product may have another address.
+    void unreachable();
+
+ private:
+    void         openStream();
+    void         closeStream();
+    void         onStreamLost(QNetworkReply* reply, const QString& reason);
+    void         onStreamIdle();
+    void         setConnectionState(ConnectionState state);
+    void         getDeviceInfo();
+    void         probeProfile(const QString& serialNumber, const QString& firmware);
+    void         resync();
+    void         setStale(bool stale);
+    void         trackVolume(const BeoVolume& volume);
+    bool         attachEntity();
+    void         setPowerState(bool on);
+    void         updateEntity(const BeoNotification& notification);
+    void         confirmStates(const BeoNotification& notification);
+    void         reportState(int attribute, const QVariant& value);
+    DoneCallback proposeState(int attribute, const QVariant& value, const DoneCallback& done);
+    void         settleStates();
+    void         updatePlaybackClock(const BeoProgress& progress);
+    void         pushPosition();
+    void         updateImage(const QString& url);
+    void         onStreamFrame(const QByteArray& frame);
+    void         onFilteredFrame(BeoNotification::Type type, const QByteArray& frame);
+    void         scheduleSampledFrames();
+    void         onNotificationFrame(const QByteArray& frame);
+    void         setExperience(const BeoSource& experience);
+
+    typedef std::function<void(const QJsonObject& object)> JsonHandler;
+
+    // get, post, put and delete requests
+    void getRequest(const QString& url, const JsonHandler& handler, const DoneCallback& done = DoneCallback(),
+                    BeoHttpClient::Priority priority = BeoHttpClient::NORMAL);
+    void commandRequest(QNetworkAccessManager::Operation operation, const QString& url, const QByteArray& body,
+                        const DoneCallback& done, const QString& orderKey = QString());
+    void postRequest(const QString& url, const QString& params, const DoneCallback& done = DoneCallback());
+    void postRequest(const QString& url, const QVariantMap& params, const DoneCallback& done = DoneCallback());
+    void putRequest(const QString& url, const QVariantMap& params, const DoneCallback& done = DoneCallback());
+    void putRequest(const QString& url);
+    void deleteRequest(const QString& url, const DoneCallback& done = DoneCallback());
+
+    QString m_ip;
+    QString m_baseUrl;
+    QString m_entityId;
+    QString m_serialNumber;
+
+    QNetworkAccessManager*  m_manager;
+    ArtworkCache*           m_artwork;
+    EntitiesInterface*      m_entities;
+    const QLoggingCategory& m_logCategory;
+
+    QNetworkReply*     m_reply = nullptr;
+    BeoHttpClient*     m_client = nullptr;
+    NotificationFramer m_framer;
+    NotificationFilter m_filter;
+    QTimer*            m_sampleTimer;  // decodes the frames held back by a sample interval
+    BeoMetrics         m_metrics;
+    ContentCache*      m_content = nullptr;
+    BeoDeviceProfile   m_profile;
+
+    // state queries after connecting, the entity is stale until they are answered
+    int  m_resyncPending = 0;
+    bool m_resyncFailed = false;
+    bool m_stale = false;
+
+    static const int UNREACHABLE_ATTEMPTS = 3;
+    ConnectionState  m_connectionState = DISCONNECTED;
+    ReconnectBackoff m_backoff;
+    QTimer*          m_reconnectTimer;
+
+    // a product that lost power leaves the stream open without sending anything
+    static const int STREAM_IDLE_TIMEOUT = 30000;
+    QTimer*          m_streamWatchdog;
+
+    // last values written to the entity
+    EntityShadow m_shadow;
+
+    // effects of commands, shown until the product reports them
+    OptimisticState m_optimistic;
+    QTimer*         m_settleTimer;
+
+    // volume and mute commands, latest value wins
+    static const int VOLUME_STEP = 2;
+    CommandCoalescer m_volumeSender;
+    CommandCoalescer m_muteSender;
+    int              m_volume = 0;
+    bool             m_muted = false;
+
+    // primary experience, shared by grouped products
+    BeoSource m_experience;
+
+    // image of the current track, the cached copy is only shown if the track did not change meanwhile
+    QString m_imageUrl;
+
+    // playback position, extrapolated between the progress events
+    static const int PROGRESS_INTERVAL_DEFAULT = 5000;
+    static const int POSITION_DRIFT_TOLERANCE = 2000;
+    PlaybackClock    m_playbackClock;
+    QTimer*          m_progressTimer;
+
+    // power state polling
+    static const int POLL_INTERVAL_MIN = 2000;
+    static const int POLL_INTERVAL_DEFAULT = 10000;
+    static const int POLL_INTERVAL_MAX = 120000;
+    QElapsedTimer    m_clock;
+    qint64           m_nextPoll = 0;
+    int              m_pollInterval = POLL_INTERVAL_DEFAULT;
+    void             getStandby(const DoneCallback& done = DoneCallback());
+    void             tightenPolling();
+
+    //    // commands to the speaker
+    void setVolume(const int& volume, const DoneCallback& done = DoneCallback());
+    void changeVolume(int delta, const DoneCallback& done = DoneCallback());
+    void setMute(const bool& value, const DoneCallback& done = DoneCallback());
+    void pressAndRelease(const QString& url, const DoneCallback& done);
+    void Play(const DoneCallback& done = DoneCallback());
+    void Pause(const DoneCallback& done = DoneCallback());
+    void Stop(const DoneCallback& done = DoneCallback());
+    void Next(const DoneCallback& done = DoneCallback());
+    void Prev(const DoneCallback& done = DoneCallback());
+    void Standby(const DoneCallback& done = DoneCallback());
+    void TurnOn(const DoneCallback& done = DoneCallback());
+};
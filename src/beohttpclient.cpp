@@ -0,0 +1,280 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "beohttpclient.h"
+
+#include <QJsonDocument>
+#include <QList>
+#include <QUrl>
+
+#include "beometrics.h"
+
+bool BeoResponse::parseJson(QJsonObject *object, QString *errorString) const {
+    QJsonParseError parseerror;
+    QJsonDocument   doc = QJsonDocument::fromJson(body, &parseerror);
+    if (parseerror.error != QJsonParseError::NoError) {
+        if (errorString) {
+            *errorString = parseerror.errorString();
+        }
+        return false;
+    }
+    *object = doc.object();
+    return true;
+}
+
+const char *BeoResponse::statusName(Status status) {
+    static const char *const NAMES[] = {"ok", "http_error", "network_error", "timeout", "cancelled"};
+    return NAMES[status];
+}
+
+BeoHttpClient::BeoHttpClient(QNetworkAccessManager *manager, const QString &baseUrl, QObject *parent)
+    : QObject(parent), m_manager(manager), m_baseUrl(baseUrl) {
+    m_clock.start();
+    m_timeouts[INTERACTIVE] = INTERACTIVE_TIMEOUT;
+    m_timeouts[NORMAL] = NORMAL_TIMEOUT;
+    m_timeouts[BACKGROUND] = BACKGROUND_TIMEOUT;
+
+    // one timer for all requests, it only runs while requests are in flight
+    m_timeoutTimer = new QTimer(this);
+    m_timeoutTimer->setInterval(500);
+    QObject::connect(m_timeoutTimer, &QTimer::timeout, this, &BeoHttpClient::onTimeoutTimer);
+}
+
+BeoHttpClient::~BeoHttpClient() {
+    // handlers may refer to objects that are being destroyed, drop the replies silently
+    for (const PendingRequest &request : m_pending) {
+        if (request.reply != nullptr) {
+            request.reply->disconnect(this);
+            request.reply->abort();
+            request.reply->deleteLater();
+        }
+    }
+    m_pending.clear();
+}
+
+quint64 BeoHttpClient::send(QNetworkAccessManager::Operation operation, const QString &path, const QByteArray &body,
+                            const Options &options, const ResponseHandler &handler) {
+    static const char *const METHODS[] = {"", "HEAD", "GET", "PUT", "POST", "DELETE"};
+
+    quint64        id = m_nextId++;
+    qint64         now = m_clock.elapsed();
+    int            timeout = options.timeout > 0 ? options.timeout : m_timeouts[options.priority];
+    PendingRequest request{operation, path, body, options, handler, nullptr, now, now + timeout, QString()};
+    if (request.options.orderKey.isEmpty()) {
+        request.options.orderKey = path.section('?', 0, 0);
+    }
+    if (m_metrics != nullptr) {
+        // query parameters would split one endpoint into many
+        request.endpoint = QString(METHODS[operation]).append(' ').append(path.section('?', 0, 0));
+    }
+    m_pending.insert(id, request);
+    if (m_cancelling) {
+        // sent by a handler of a cancelled request, cancelAll() cancels it before it returns
+        return id;
+    }
+    m_queues[options.priority].append(id);
+
+    if (!m_timeoutTimer->isActive()) {
+        m_timeoutTimer->start();
+    }
+    dispatch();
+    return id;
+}
+
+quint64 BeoHttpClient::get(const QString &path, const ResponseHandler &handler) {
+    return send(QNetworkAccessManager::GetOperation, path, QByteArray(), Options(), handler);
+}
+
+quint64 BeoHttpClient::post(const QString &path, const QByteArray &body, const ResponseHandler &handler) {
+    return send(QNetworkAccessManager::PostOperation, path, body, Options(), handler);
+}
+
+quint64 BeoHttpClient::put(const QString &path, const QByteArray &body, const ResponseHandler &handler) {
+    return send(QNetworkAccessManager::PutOperation, path, body, Options(), handler);
+}
+
+quint64 BeoHttpClient::deleteResource(const QString &path, const ResponseHandler &handler) {
+    return send(QNetworkAccessManager::DeleteOperation, path, QByteArray(), Options(), handler);
+}
+
+void BeoHttpClient::cancel(quint64 id) {
+    abort(id, BeoResponse::CANCELLED, QStringLiteral("Request cancelled"));
+}
+
+void BeoHttpClient::cancelAll() {
+    // queued requests must not start while the ones before them are cancelled
+    for (QList<quint64> &queue : m_queues) {
+        queue.clear();
+    }
+    // handlers may send new requests, they are cancelled as well instead of outliving the call
+    m_cancelling = true;
+    while (!m_pending.isEmpty()) {
+        cancel(m_pending.cbegin().key());
+    }
+    m_cancelling = false;
+}
+
+void BeoHttpClient::setTimeout(Priority priority, int msecs) {
+    // applies to the requests sent from now on
+    if (msecs > 0) {
+        m_timeouts[priority] = msecs;
+    }
+}
+
+QNetworkRequest BeoHttpClient::createRequest(const QString &path, const RawHeaders &headers) const {
+    QNetworkRequest request(QUrl(m_baseUrl + path));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    // keep the connection open for the next command, Qt reuses it for the same host
+    request.setRawHeader("Connection", "keep-alive");
+    for (auto iter = headers.cbegin(); iter != headers.cend(); ++iter) {
+        request.setRawHeader(iter.key(), iter.value());
+    }
+    return request;
+}
+
+void BeoHttpClient::dispatch() {
+    for (int priority = INTERACTIVE; priority <= BACKGROUND; priority++) {
+        // the last slots are kept free for requests of higher priority
+        int limit = MAX_IN_FLIGHT - priority;
+
+        QList<quint64> &queue = m_queues[priority];
+        for (auto iter = queue.begin(); iter != queue.end() && m_running < limit;) {
+            PendingRequest &request = m_pending[*iter];
+            // a request waits for the one before it on the same resource, the later ones have to wait as well
+            if (m_busyKeys.contains(request.options.orderKey)) {
+                ++iter;
+                continue;
+            }
+            start(*iter, &request);
+            iter = queue.erase(iter);
+        }
+    }
+}
+
+void BeoHttpClient::start(quint64 id, PendingRequest *request) {
+    QNetworkRequest networkRequest = createRequest(request->path, request->options.headers);
+    switch (request->operation) {
+        case QNetworkAccessManager::PostOperation:
+            request->reply = m_manager->post(networkRequest, request->body);
+            break;
+        case QNetworkAccessManager::PutOperation:
+            request->reply = m_manager->put(networkRequest, request->body);
+            break;
+        case QNetworkAccessManager::DeleteOperation:
+            request->reply = m_manager->deleteResource(networkRequest);
+            break;
+        default:
+            request->reply = m_manager->get(networkRequest);
+            break;
+    }
+    request->started = m_clock.elapsed();
+    request->body.clear();
+
+    m_running++;
+    m_busyKeys.insert(request->options.orderKey);
+    QObject::connect(request->reply, &QNetworkReply::finished, this, [this, id]() { onFinished(id); });
+}
+
+void BeoHttpClient::release(quint64 id, const PendingRequest &request) {
+    if (request.reply != nullptr) {
+        m_running--;
+        m_busyKeys.remove(request.options.orderKey);
+    } else {
+        m_queues[request.options.priority].removeOne(id);
+    }
+}
+
+void BeoHttpClient::onFinished(quint64 id) {
+    auto iter = m_pending.find(id);
+    if (iter == m_pending.end()) {
+        return;
+    }
+    PendingRequest request = iter.value();
+    m_pending.erase(iter);
+
+    BeoResponse response;
+    response.id = id;
+    response.httpStatus = request.reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    response.body = request.reply->readAll();
+    response.etag = request.reply->rawHeader("ETag");
+    response.lastModified = request.reply->rawHeader("Last-Modified");
+    if (request.reply->error() != QNetworkReply::NoError) {
+        response.status = response.httpStatus >= 400 ? BeoResponse::HTTP_ERROR : BeoResponse::NETWORK_ERROR;
+        response.errorString = request.reply->errorString();
+    }
+    request.reply->deleteLater();
+
+    // the next request on the same resource may start now
+    release(id, request);
+    dispatch();
+    finish(request, response);
+}
+
+void BeoHttpClient::abort(quint64 id, BeoResponse::Status status, const QString &errorString) {
+    auto iter = m_pending.find(id);
+    if (iter == m_pending.end()) {
+        return;
+    }
+    PendingRequest request = iter.value();
+    m_pending.erase(iter);
+
+    // the finished signal of the aborted reply must not reach onFinished
+    if (request.reply != nullptr) {
+        request.reply->disconnect(this);
+        request.reply->abort();
+        request.reply->deleteLater();
+    }
+    release(id, request);
+    dispatch();
+
+    BeoResponse response;
+    response.id = id;
+    response.status = status;
+    response.errorString = errorString;
+    finish(request, response);
+}
+
+void BeoHttpClient::onTimeoutTimer() {
+    qint64         now = m_clock.elapsed();
+    QList<quint64> expired;
+    for (auto iter = m_pending.cbegin(); iter != m_pending.cend(); ++iter) {
+        if (iter.value().deadline <= now) {
+            expired.append(iter.key());
+        }
+    }
+    for (quint64 id : expired) {
+        abort(id, BeoResponse::TIMEOUT, QStringLiteral("Request timed out"));
+    }
+
+    if (m_pending.isEmpty()) {
+        m_timeoutTimer->stop();
+    }
+}
+
+void BeoHttpClient::finish(const PendingRequest &request, const BeoResponse &response) {
+    if (m_metrics != nullptr && !request.endpoint.isEmpty()) {
+        m_metrics->recordRequest(request.endpoint, m_clock.elapsed() - request.started, response.status);
+    }
+    if (request.handler) {
+        request.handler(response);
+    }
+}
@@ -0,0 +1,170 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+
+class BeoMetrics;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// BANG&OLUFSEN HTTP CLIENT
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Outcome of one REST request.
+struct BeoResponse {
+    enum Status { OK, HTTP_ERROR, NETWORK_ERROR, TIMEOUT, CANCELLED };
+
+    quint64    id = 0;
+    Status     status = OK;
+    int        httpStatus = 0;
+    QByteArray body;
+    QString    errorString;
+
+    // cache validators of the resource, if the product sends them
+    QByteArray etag;
+    QByteArray lastModified;
+
+    bool isOk() const { return status == OK; }
+
+    /// "ok", "http_error", "network_error", "timeout" or "cancelled", for logs and metrics.
+    static const char* statusName(Status status);
+
+    /// The resource did not change since the validators sent with a conditional request.
+    bool isNotModified() const { return status == OK && httpStatus == 304; }
+
+    /// Parses the body as a JSON object. Returns false and sets errorString if it is not valid JSON.
+    bool parseJson(QJsonObject* object, QString* errorString = nullptr) const;
+};
+
+/// REST client of one Bang & Olufsen product.
+/// All requests go through the same long-lived QNetworkAccessManager, which keeps the HTTP/1.1 connections to the
+/// product open between requests. No manager or helper object is created per request.
+/// Every request gets an id and is kept in an in-flight table until its handler was called exactly once: when the
+/// reply finished, when it timed out or when it was cancelled.
+/// Requests are scheduled per product: requests with the same order key run one after the other in the order they
+/// were sent, independent ones run in parallel. Interactive requests are sent first and always find a free slot,
+/// polling and background requests never take all of them.
+/// Every request has a deadline, counted from send() so the time waiting in the queue is included. It defaults to the
+/// timeout of its priority, a command gives up sooner than a background query.
+class BeoHttpClient : public QObject {
+    Q_OBJECT
+
+ public:
+    typedef std::function<void(const BeoResponse& response)> ResponseHandler;
+    typedef QHash<QByteArray, QByteArray>                    RawHeaders;
+
+    enum Priority { INTERACTIVE, NORMAL, BACKGROUND };
+
+    struct Options {
+        Priority   priority = NORMAL;
+        QString    orderKey;  // defaults to the path without query
+        RawHeaders headers;
+        int        timeout = 0;  // ms, 0 uses the timeout of the priority
+    };
+
+    // default timeouts of the priorities in ms
+    static const int INTERACTIVE_TIMEOUT = 3000;
+    static const int NORMAL_TIMEOUT = 5000;
+    static const int BACKGROUND_TIMEOUT = 10000;
+
+    // Qt opens up to 6 connections per host, one of them is taken by the notification stream
+    static const int MAX_IN_FLIGHT = 4;
+
+    BeoHttpClient(QNetworkAccessManager* manager, const QString& baseUrl, QObject* parent = nullptr);
+    ~BeoHttpClient() override;
+
+    const QString& baseUrl() const { return m_baseUrl; }
+    void           setBaseUrl(const QString& baseUrl) { m_baseUrl = baseUrl; }
+
+    /// The requests return the id of the request, which can be used to cancel it.
+    quint64 send(QNetworkAccessManager::Operation operation, const QString& path, const QByteArray& body,
+                 const Options& options, const ResponseHandler& handler = ResponseHandler());
+    quint64 get(const QString& path, const ResponseHandler& handler = ResponseHandler());
+    quint64 post(const QString& path, const QByteArray& body = QByteArray(),
+                 const ResponseHandler& handler = ResponseHandler());
+    quint64 put(const QString& path, const QByteArray& body, const ResponseHandler& handler = ResponseHandler());
+    quint64 deleteResource(const QString& path, const ResponseHandler& handler = ResponseHandler());
+
+    void cancel(quint64 id);
+    /// Cancels all requests, including the ones sent by the handlers while they are cancelled.
+    void cancelAll();
+
+    int  timeout(Priority priority) const { return m_timeouts[priority]; }
+    void setTimeout(Priority priority, int msecs);
+
+    /// Requests sent to the product, and requests waiting for their turn.
+    int inFlightCount() const { return m_running; }
+    int queuedCount() const { return m_pending.size() - m_running; }
+
+    /// Latency and outcome of every request are recorded in metrics, if set.
+    void setMetrics(BeoMetrics* metrics) { m_metrics = metrics; }
+
+ private:
+    struct PendingRequest {
+        QNetworkAccessManager::Operation operation;
+        QString                          path;
+        QByteArray                       body;
+        Options                          options;
+        ResponseHandler                  handler;
+        QNetworkReply*                   reply;  // null while queued
+        qint64                           started;
+        qint64                           deadline;
+        QString                          endpoint;
+    };
+
+    QNetworkRequest createRequest(const QString& path, const RawHeaders& headers) const;
+    void            dispatch();
+    void            start(quint64 id, PendingRequest* request);
+    void            release(quint64 id, const PendingRequest& request);
+    void            onFinished(quint64 id);
+    void            abort(quint64 id, BeoResponse::Status status, const QString& errorString);
+    void            onTimeoutTimer();
+    void            finish(const PendingRequest& request, const BeoResponse& response);
+
+    QNetworkAccessManager* m_manager;
+    QString                m_baseUrl;
+
+    QHash<quint64, PendingRequest> m_pending;
+    QList<quint64>                 m_queues[BACKGROUND + 1];  // by priority, oldest first
+    int                            m_timeouts[BACKGROUND + 1];
+    QSet<QString>                  m_busyKeys;
+    int                            m_running = 0;
+    quint64                        m_nextId = 1;
+    bool                           m_cancelling = false;
+    QElapsedTimer                  m_clock;
+    QTimer*                        m_timeoutTimer;
+    BeoMetrics*                    m_metrics = nullptr;
+};
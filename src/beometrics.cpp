@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "beometrics.h"
+
+#include <QVariantList>
+#include <QtGlobal>
+
+const int LatencyHistogram::BUCKET_BOUNDS[LatencyHistogram::BUCKET_COUNT - 1] = {10,  25,   50,   100, 250,
+                                                                                 500, 1000, 2500, 5000};
+
+// indexed by BeoNotification::Type
+static const char *const NOTIFICATION_TYPE_NAMES[] = {
+    "UNKNOWN", "VOLUME", "SOURCE", "PROGRESS_INFORMATION", "NOW_PLAYING_STORED_MUSIC", "NOW_PLAYING_NET_RADIO",
+    "SHUTDOWN", "STANDBY"};
+Q_STATIC_ASSERT(sizeof(NOTIFICATION_TYPE_NAMES) / sizeof(NOTIFICATION_TYPE_NAMES[0]) == BeoNotification::STANDBY + 1);
+
+void LatencyHistogram::record(qint64 msecs) {
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && msecs > BUCKET_BOUNDS[bucket]) {
+        bucket++;
+    }
+    buckets[bucket]++;
+    count++;
+    total += msecs;
+    max = qMax(max, msecs);
+}
+
+QVariantMap LatencyHistogram::toVariantMap() const {
+    // bucket i counts the requests up to bounds[i], the last one those above all bounds
+    QVariantList bounds;
+    QVariantList counts;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        if (i < BUCKET_COUNT - 1) {
+            bounds.append(BUCKET_BOUNDS[i]);
+        }
+        counts.append(buckets[i]);
+    }
+
+    QVariantMap map;
+    map.insert("count", count);
+    map.insert("avg_ms", count > 0 ? static_cast<double>(total) / count : 0.0);
+    map.insert("max_ms", max);
+    map.insert("bucket_bounds_ms", bounds);
+    map.insert("buckets", counts);
+    return map;
+}
+
+BeoMetrics::BeoMetrics() {
+    m_clock.start();
+}
+
+void BeoMetrics::recordRequest(const QString &endpoint, qint64 msecs, BeoResponse::Status status) {
+    // the table must not grow with every browsed folder over days of uptime
+    bool           known = m_endpoints.contains(endpoint) || m_endpoints.size() < MAX_ENDPOINTS;
+    EndpointStats &stats = m_endpoints[known ? endpoint : QStringLiteral("other")];
+    switch (status) {
+        case BeoResponse::OK:
+            stats.latency.record(msecs);
+            break;
+        case BeoResponse::HTTP_ERROR:
+            // the product answered, the latency is valid
+            stats.latency.record(msecs);
+            stats.failed++;
+            break;
+        case BeoResponse::NETWORK_ERROR:
+            stats.failed++;
+            break;
+        case BeoResponse::TIMEOUT:
+            stats.timedOut++;
+            break;
+        case BeoResponse::CANCELLED:
+            stats.cancelled++;
+            break;
+    }
+}
+
+void BeoMetrics::recordNotification(BeoNotification::Type type, qint64 parseNsecs) {
+    m_notifications[type]++;
+    m_parsed++;
+    recordParseTime(parseNsecs);
+}
+
+void BeoMetrics::recordParseFailure(qint64 parseNsecs) {
+    m_parseFailures++;
+    recordParseTime(parseNsecs);
+}
+
+void BeoMetrics::recordParseTime(qint64 parseNsecs) {
+    m_parseNsecs += parseNsecs;
+    m_parseMaxNsecs = qMax(m_parseMaxNsecs, parseNsecs);
+}
+
+void BeoMetrics::setStreamConnected(bool connected) {
+    qint64 now = m_clock.elapsed();
+    if (connected && m_connectedSince < 0) {
+        m_connectedSince = now;
+    } else if (!connected && m_connectedSince >= 0) {
+        m_streamUptime += now - m_connectedSince;
+        m_connectedSince = -1;
+    }
+}
+
+QVariantMap BeoMetrics::toVariantMap() const {
+    qint64 now = m_clock.elapsed();
+    double seconds = qMax<qint64>(now, 1) / 1000.0;
+
+    QVariantMap requests;
+    for (auto iter = m_endpoints.cbegin(); iter != m_endpoints.cend(); ++iter) {
+        QVariantMap endpoint = iter.value().latency.toVariantMap();
+        endpoint.insert("failed", iter.value().failed);
+        endpoint.insert("timed_out", iter.value().timedOut);
+        endpoint.insert("cancelled", iter.value().cancelled);
+        requests.insert(iter.key(), endpoint);
+    }
+
+    QVariantMap notifications;
+    for (int type = 0; type < NOTIFICATION_TYPE_COUNT; type++) {
+        if (m_notifications[type] > 0 || m_filtered[type] > 0) {
+            QVariantMap entry;
+            entry.insert("count", m_notifications[type]);
+            entry.insert("per_minute", m_notifications[type] * 60.0 / seconds);
+            entry.insert("filtered", m_filtered[type]);
+            notifications.insert(NOTIFICATION_TYPE_NAMES[type], entry);
+        }
+    }
+
+    quint64     frames = m_parsed + m_parseFailures;
+    QVariantMap parsing;
+    parsing.insert("frames", frames);
+    parsing.insert("failures", m_parseFailures);
+    parsing.insert("avg_us", frames > 0 ? m_parseNsecs / 1000.0 / frames : 0.0);
+    parsing.insert("max_us", m_parseMaxNsecs / 1000.0);
+
+    QVariantMap stream;
+    stream.insert("reconnects", m_reconnects);
+    stream.insert("connected_ms", m_connectedSince >= 0 ? now - m_connectedSince : 0);
+    stream.insert("uptime_ms", m_streamUptime + (m_connectedSince >= 0 ? now - m_connectedSince : 0));
+    stream.insert("tracked_ms", now);
+
+    QVariantMap map;
+    map.insert("requests", requests);
+    map.insert("notifications", notifications);
+    map.insert("parsing", parsing);
+    map.insert("stream", stream);
+    return map;
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+
+#include "beohttpclient.h"
+#include "notificationdecoder.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// METRICS
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Request latency histogram with fixed buckets, recording is a few integer operations.
+struct LatencyHistogram {
+    static const int BUCKET_COUNT = 10;
+
+    /// Upper bounds of the buckets in ms, the last bucket takes everything above.
+    static const int BUCKET_BOUNDS[BUCKET_COUNT - 1];
+
+    quint64 buckets[BUCKET_COUNT] = {};
+    quint64 count = 0;
+    qint64  total = 0;
+    qint64  max = 0;
+
+    void        record(qint64 msecs);
+    QVariantMap toVariantMap() const;
+};
+
+/// Runtime counters of one Bang & Olufsen product: REST latency per endpoint, notifications per type, JSON parse cost
+/// and stream reconnects. Everything is updated in place, nothing is allocated per event except for a new endpoint.
+class BeoMetrics {
+ public:
+    /// Content browsing has a path per folder, the endpoints beyond this count share one entry.
+    static const int MAX_ENDPOINTS = 64;
+
+    BeoMetrics();
+
+    /// endpoint is the method and the path without query, e.g. "GET /BeoZone/Zone/ActiveSources".
+    void recordRequest(const QString& endpoint, qint64 msecs, BeoResponse::Status status);
+
+    void recordNotification(BeoNotification::Type type, qint64 parseNsecs);
+    void recordParseFailure(qint64 parseNsecs);
+
+    /// A frame that was not decoded, dropped or held back by the notification filter or of an unhandled type.
+    void recordFiltered(BeoNotification::Type type) { m_filtered[type]++; }
+
+    void recordReconnect() { m_reconnects++; }
+    void setStreamConnected(bool connected);
+
+    QVariantMap toVariantMap() const;
+
+ private:
+    struct EndpointStats {
+        LatencyHistogram latency;
+        quint64          failed = 0;
+        quint64          timedOut = 0;
+        quint64          cancelled = 0;
+    };
+
+    static const int NOTIFICATION_TYPE_COUNT = BeoNotification::STANDBY + 1;
+
+    void recordParseTime(qint64 parseNsecs);
+
+    QElapsedTimer m_clock;
+
+    QHash<QString, EndpointStats> m_endpoints;
+
+    quint64 m_notifications[NOTIFICATION_TYPE_COUNT] = {};
+    quint64 m_filtered[NOTIFICATION_TYPE_COUNT] = {};
+    quint64 m_parsed = 0;
+    quint64 m_parseFailures = 0;
+    qint64  m_parseNsecs = 0;
+    qint64  m_parseMaxNsecs = 0;
+
+    int    m_reconnects = 0;
+    qint64 m_streamUptime = 0;
+    qint64 m_connectedSince = -1;
+};
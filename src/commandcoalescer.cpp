@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "commandcoalescer.h"
+
+CommandCoalescer::CommandCoalescer(const SendFunction &send) : m_send(send) {}
+
+void CommandCoalescer::submit(const QVariant &value, const DoneCallback &done) {
+    if (m_inFlight) {
+        // replaces an older pending value, it would be outdated anyway
+        m_pending = value;
+        if (done) {
+            m_pendingWaiters.append(done);
+        }
+    } else {
+        if (done) {
+            m_inFlightWaiters.append(done);
+        }
+        sendNow(value);
+    }
+}
+
+void CommandCoalescer::reset() {
+    m_generation++;
+    m_inFlight = false;
+    m_inFlightValue.clear();
+    m_pending.clear();
+
+    QList<DoneCallback> waiters = m_inFlightWaiters + m_pendingWaiters;
+    m_inFlightWaiters.clear();
+    m_pendingWaiters.clear();
+    for (const DoneCallback &waiter : waiters) {
+        waiter(false);
+    }
+}
+
+QVariant CommandCoalescer::targetValue() const { return m_pending.isValid() ? m_pending : m_inFlightValue; }
+
+void CommandCoalescer::sendNow(const QVariant &value) {
+    m_inFlight = true;
+    m_inFlightValue = value;
+    int generation = m_generation;
+    m_send(value, [this, generation](bool success) { onDone(generation, success); });
+}
+
+void CommandCoalescer::onDone(int generation, bool success) {
+    if (generation != m_generation) {
+        return;
+    }
+
+    QList<DoneCallback> waiters = m_inFlightWaiters;
+    m_inFlightWaiters.clear();
+    m_inFlight = false;
+    m_inFlightValue.clear();
+
+    if (m_pending.isValid()) {
+        // callers of replaced values are answered together with the newest value
+        QVariant next = m_pending;
+        m_pending.clear();
+        m_inFlightWaiters.swap(m_pendingWaiters);
+        sendNow(next);
+    }
+
+    for (const DoneCallback &waiter : waiters) {
+        waiter(success);
+    }
+}
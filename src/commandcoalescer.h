@@ -0,0 +1,66 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QList>
+#include <QVariant>
+
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// COMMAND COALESCER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Latest-wins sender for absolute value commands like volume level or mute.
+/// At most one request is in flight. Values submitted meanwhile replace each other and only the newest one is sent
+/// when the running request is done.
+class CommandCoalescer {
+ public:
+    typedef std::function<void(bool success)>                                    DoneCallback;
+    typedef std::function<void(const QVariant& value, const DoneCallback& done)> SendFunction;
+
+    explicit CommandCoalescer(const SendFunction& send);
+
+    /// done is called once the value, or a newer one that replaced it, was sent and answered.
+    void submit(const QVariant& value, const DoneCallback& done = DoneCallback());
+
+    /// Forgets the pending value, a late answer of the request in flight is ignored. Waiting callers fail.
+    void reset();
+
+    bool isBusy() const { return m_inFlight; }
+
+    /// The newest submitted value while a request is running or pending, otherwise invalid.
+    QVariant targetValue() const;
+
+ private:
+    void sendNow(const QVariant& value);
+    void onDone(int generation, bool success);
+
+    SendFunction        m_send;
+    QVariant            m_inFlightValue;
+    QVariant            m_pending;
+    QList<DoneCallback> m_inFlightWaiters;
+    QList<DoneCallback> m_pendingWaiters;
+    bool                m_inFlight = false;
+    int                 m_generation = 0;
+};
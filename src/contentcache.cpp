@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "contentcache.h"
+
+ContentCache::ContentCache(BeoHttpClient *client) : m_client(client), m_entries(MAX_SIZE) {
+    m_clock.start();
+}
+
+void ContentCache::fetch(const QString &path, int offset, int count, const PageHandler &handler) {
+    QString key = path;
+    if (count > 0) {
+        key.append(path.contains('?') ? '&' : '?').append(QString("offset=%1&count=%2").arg(offset).arg(count));
+    }
+
+    Entry *entry = m_entries.object(key);
+    if (entry && !entry->stale && m_clock.elapsed() - entry->validatedAt < MAX_AGE) {
+        handler(true, entry->page);
+        return;
+    }
+
+    // merge with a request for the same page that is still running
+    auto waiting = m_pending.find(key);
+    if (waiting != m_pending.end()) {
+        waiting->append(handler);
+        return;
+    }
+    m_pending.insert(key, QList<PageHandler>{handler});
+
+    BeoHttpClient::Options options;
+    if (entry) {
+        if (!entry->etag.isEmpty()) {
+            options.headers.insert("If-None-Match", entry->etag);
+        }
+        if (!entry->lastModified.isEmpty()) {
+            options.headers.insert("If-Modified-Since", entry->lastModified);
+        }
+    }
+    m_client->send(QNetworkAccessManager::GetOperation, key, QByteArray(), options,
+                   [this, key](const BeoResponse &response) { onResponse(key, response); });
+}
+
+void ContentCache::invalidate(const QString &pathPrefix) {
+    const QList<QString> keys = m_entries.keys();
+    for (const QString &key : keys) {
+        if (pathPrefix.isEmpty() || key.startsWith(pathPrefix)) {
+            m_entries.object(key)->stale = true;
+        }
+    }
+}
+
+void ContentCache::onResponse(const QString &key, const BeoResponse &response) {
+    Entry *entry = m_entries.object(key);
+
+    if (response.isNotModified() && entry) {
+        entry->stale = false;
+        entry->validatedAt = m_clock.elapsed();
+        finish(key, true, entry->page);
+        return;
+    }
+
+    QJsonObject page;
+    if (!response.isOk() || !response.parseJson(&page)) {
+        // better an old list than none, it is revalidated on the next fetch
+        if (entry) {
+            finish(key, true, entry->page);
+        } else {
+            finish(key, false, QJsonObject());
+        }
+        return;
+    }
+
+    m_entries.insert(key, new Entry{page, response.etag, response.lastModified, m_clock.elapsed(), false},
+                     qMax(1, response.body.size()));
+    finish(key, true, page);
+}
+
+void ContentCache::finish(const QString &key, bool ok, const QJsonObject &page) {
+    const QList<PageHandler> handlers = m_pending.take(key);
+    for (const PageHandler &handler : handlers) {
+        handler(ok, page);
+    }
+}
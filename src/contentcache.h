@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+#include "beohttpclient.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// CONTENT CACHE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Cache of the browsable resources of one product: the source list and the BeoContent tree.
+/// Lists are loaded in pages on demand. A cached page is handed out directly while it is fresh. After MAX_AGE or
+/// after invalidate() it is revalidated with a conditional request (If-None-Match / If-Modified-Since) if the product
+/// sent validators, so an unchanged list is not downloaded again. Requests for a page that is already loading wait
+/// for the same request.
+class ContentCache {
+ public:
+    /// Called with the JSON object of the page. ok is false if it could neither be loaded nor taken from the cache.
+    typedef std::function<void(bool ok, const QJsonObject& page)> PageHandler;
+
+    static const int DEFAULT_PAGE_SIZE = 50;
+    static const int MAX_AGE = 60000;
+    static const int MAX_SIZE = 2 * 1024 * 1024;
+
+    explicit ContentCache(BeoHttpClient* client);
+
+    /// Loads count entries of the list at path, starting at offset. With count 0 the resource is loaded unpaged.
+    void fetch(const QString& path, int offset, int count, const PageHandler& handler);
+
+    /// Marks the cached pages below pathPrefix as stale, all pages if it is empty. They are revalidated on the next
+    /// fetch.
+    void invalidate(const QString& pathPrefix = QString());
+
+ private:
+    struct Entry {
+        QJsonObject page;
+        QByteArray  etag;
+        QByteArray  lastModified;
+        qint64      validatedAt;
+        bool        stale;
+    };
+
+    void onResponse(const QString& key, const BeoResponse& response);
+    void finish(const QString& key, bool ok, const QJsonObject& page);
+
+    BeoHttpClient* m_client;
+    QElapsedTimer  m_clock;
+
+    // key is the path including the paging parameters, the cost is the size of the body
+    QCache<QString, Entry> m_entries;
+
+    QHash<QString, QList<PageHandler>> m_pending;
+};
@@ -0,0 +1,141 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "deviceprofile.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+static const char KEY_SERIAL_NUMBER[] = "serialNumber";
+static const char KEY_FIRMWARE[] = "firmware";
+static const char KEY_FEATURES[] = "features";
+static const char KEY_SOURCES[] = "sources";
+
+QJsonObject BeoDeviceProfile::toJson() const {
+    QJsonObject object;
+    object.insert(KEY_SERIAL_NUMBER, serialNumber);
+    object.insert(KEY_FIRMWARE, firmware);
+    object.insert(KEY_FEATURES, QJsonArray::fromStringList(features));
+    object.insert(KEY_SOURCES, QJsonArray::fromStringList(sources));
+    return object;
+}
+
+BeoDeviceProfile BeoDeviceProfile::fromJson(const QJsonObject &object) {
+    BeoDeviceProfile profile;
+    profile.serialNumber = object.value(KEY_SERIAL_NUMBER).toString();
+    profile.firmware = object.value(KEY_FIRMWARE).toString();
+    for (const QJsonValue &feature : object.value(KEY_FEATURES).toArray()) {
+        profile.features.append(feature.toString());
+    }
+    for (const QJsonValue &source : object.value(KEY_SOURCES).toArray()) {
+        profile.sources.append(source.toString());
+    }
+    return profile;
+}
+
+QStringList BeoDeviceProfile::defaultFeatures() {
+    QStringList features;
+    features << "SOURCE"
+             << "VOLUME"
+             << "VOLUME_UP"
+             << "VOLUME_DOWN"
+             << "VOLUME_SET"
+             << "MUTE"
+             << "MUTE_SET"
+             << "MEDIA_TITLE"
+             << "MEDIA_ARTIST"
+             << "MEDIA_DURATION"
+             << "MEDIA_POSITION"
+             << "MEDIA_IMAGE"
+             << "PLAY"
+             << "PAUSE"
+             << "STOP"
+             << "PREVIOUS"
+             << "NEXT"
+             << "TURN_ON"
+             << "TURN_OFF";
+    return features;
+}
+
+QStringList BeoDeviceProfile::featuresFromZone(const QJsonObject &zone, bool hasSources) {
+    QStringList features;
+    if (zone.contains("sound")) {
+        features << "VOLUME"
+                 << "VOLUME_UP"
+                 << "VOLUME_DOWN"
+                 << "VOLUME_SET"
+                 << "MUTE"
+                 << "MUTE_SET";
+    }
+    if (zone.contains("stream")) {
+        features << "MEDIA_TITLE"
+                 << "MEDIA_ARTIST"
+                 << "MEDIA_DURATION"
+                 << "MEDIA_POSITION"
+                 << "MEDIA_IMAGE"
+                 << "PLAY"
+                 << "PAUSE"
+                 << "STOP"
+                 << "PREVIOUS"
+                 << "NEXT";
+    }
+    if (features.isEmpty()) {
+        return features;
+    }
+    if (hasSources) {
+        features << "SOURCE";
+    }
+    // every product has a standby, it is part of /BeoDevice
+    features << "TURN_ON"
+             << "TURN_OFF";
+    return features;
+}
+
+DeviceProfileStore::DeviceProfileStore(const QString &directory) : m_directory(directory) {
+    m_directory.mkpath(".");
+}
+
+BeoDeviceProfile DeviceProfileStore::load(const QString &entityId) const {
+    QFile file(m_directory.filePath(fileName(entityId)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return BeoDeviceProfile();
+    }
+    return BeoDeviceProfile::fromJson(QJsonDocument::fromJson(file.readAll()).object());
+}
+
+bool DeviceProfileStore::save(const QString &entityId, const BeoDeviceProfile &profile) {
+    // written completely or not at all, a broken profile would only be noticed at the next start
+    QSaveFile file(m_directory.filePath(fileName(entityId)));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(profile.toJson()).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+QString DeviceProfileStore::fileName(const QString &entityId) const {
+    return QString::fromLatin1(QCryptographicHash::hash(entityId.toUtf8(), QCryptographicHash::Sha1).toHex()) +
+           ".json";
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QDir>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// DEVICE PROFILE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Capabilities and sources of one product, probed from /BeoDevice and /BeoZone.
+/// The profile belongs to a firmware version of a product, it is probed again when either changed.
+struct BeoDeviceProfile {
+    QString     serialNumber;
+    QString     firmware;
+    QStringList features;  // supported features of the media player entity
+    QStringList sources;   // ids of the sources
+
+    bool isValid() const { return !serialNumber.isEmpty() && !features.isEmpty(); }
+    bool matches(const QString& serial, const QString& version) const {
+        return isValid() && serialNumber == serial && firmware == version;
+    }
+
+    QJsonObject             toJson() const;
+    static BeoDeviceProfile fromJson(const QJsonObject& object);
+
+    /// Features implemented by the integration, used until a product was probed.
+    static QStringList defaultFeatures();
+
+    /// Features of the /BeoZone/Zone resource of a product. Empty if the zone does not tell.
+    static QStringList featuresFromZone(const QJsonObject& zone, bool hasSources);
+};
+
+/// Profiles of the products on disk, one small JSON file per entity. Loaded at startup, so the entities are
+/// registered with their features before any product answered.
+class DeviceProfileStore {
+ public:
+    explicit DeviceProfileStore(const QString& directory);
+
+    /// Returns an invalid profile if none was stored.
+    BeoDeviceProfile load(const QString& entityId) const;
+    bool             save(const QString& entityId, const BeoDeviceProfile& profile);
+
+ private:
+    QString fileName(const QString& entityId) const;
+
+    QDir m_directory;
+};
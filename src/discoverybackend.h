@@ -0,0 +1,47 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// DISCOVERY BACKEND
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Finds the instances of a DNS-SD service type on the local network.
+/// The backend is replaceable, e.g. by one asking a local stand-in responder or the discovery of the platform.
+class DiscoveryBackend : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit DiscoveryBackend(QObject* parent = nullptr) : QObject(parent) {}
+
+    /// Starts a search for instances of serviceType, e.g. "_beoremote._tcp". Instances are reported by serviceFound,
+    /// also instances that were already reported by an earlier search.
+    virtual void browse(const QString& serviceType) = 0;
+
+ signals:
+    void serviceFound(const QString& name, const QHostAddress& address, quint16 port);
+};
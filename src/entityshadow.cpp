@@ -0,0 +1,112 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "entityshadow.h"
+
+void EntityShadow::attach(EntityInterface *entity) {
+    if (entity != nullptr && entity == m_entity) {
+        return;
+    }
+
+    reset();
+    m_entity = entity;
+    if (entity != nullptr) {
+        m_isSupported = [entity](int feature) { return entity->isSupported(feature); };
+        m_update = [entity](int attribute, const QVariant &value) { entity->updateAttrByIndex(attribute, value); };
+    }
+}
+
+void EntityShadow::attach(const SupportedFunction &isSupported, const UpdateFunction &update) {
+    reset();
+    m_isSupported = isSupported;
+    m_update = update;
+}
+
+void EntityShadow::reset() {
+    m_entity = nullptr;
+    m_isSupported = SupportedFunction();
+    m_update = UpdateFunction();
+    m_featuresKnown = 0;
+    m_featuresSupported = 0;
+    m_values.clear();
+    m_held.clear();
+}
+
+bool EntityShadow::supports(int feature) {
+    if (!isAttached() || feature < 0 || feature >= 64) {
+        return false;
+    }
+
+    quint64 bit = Q_UINT64_C(1) << feature;
+    if (!(m_featuresKnown & bit)) {
+        m_featuresKnown |= bit;
+        if (m_isSupported(feature)) {
+            m_featuresSupported |= bit;
+        }
+    }
+    return m_featuresSupported & bit;
+}
+
+bool EntityShadow::set(int attribute, const QVariant &value) {
+    if (!isAttached() || attribute < 0) {
+        return false;
+    }
+
+    if (attribute >= m_values.size()) {
+        m_values.resize(attribute + 1);
+    }
+    if (m_values.at(attribute).isValid() && m_values.at(attribute) == value) {
+        return false;
+    }
+
+    if (m_holds > 0) {
+        if (!m_held.contains(attribute)) {
+            m_held.insert(attribute, m_values.at(attribute));
+        }
+        m_values[attribute] = value;
+        return true;
+    }
+
+    m_values[attribute] = value;
+    m_update(attribute, value);
+    return true;
+}
+
+void EntityShadow::clear() {
+    m_values.clear();
+    m_held.clear();
+}
+
+void EntityShadow::release() {
+    if (m_holds == 0 || --m_holds > 0) {
+        return;
+    }
+
+    // an attribute that went back to its previous value is not written at all
+    for (auto iter = m_held.cbegin(); iter != m_held.cend(); ++iter) {
+        const QVariant &value = m_values.at(iter.key());
+        if (isAttached() && (!iter.value().isValid() || iter.value() != value)) {
+            m_update(iter.key(), value);
+        }
+    }
+    m_held.clear();
+}
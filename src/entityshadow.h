@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QVariant>
+#include <QVector>
+
+#include <functional>
+
+#include "yio-interface/entities/entityinterface.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// ENTITY SHADOW
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Remembers the last value written to each attribute of an entity and only forwards changed values.
+/// Supported features are queried once per feature and then answered from a bitmask.
+/// While held, writes are collected and only the net change of each attribute is forwarded on release, so a burst of
+/// notifications crosses to the UI thread once.
+/// The shadow writes through functions, so it also runs without the remote, e.g. in benchmarks.
+class EntityShadow {
+ public:
+    typedef std::function<bool(int feature)>                          SupportedFunction;
+    typedef std::function<void(int attribute, const QVariant& value)> UpdateFunction;
+
+    void             attach(EntityInterface* entity);
+    void             attach(const SupportedFunction& isSupported, const UpdateFunction& update);
+    bool             isAttached() const { return static_cast<bool>(m_update); }
+    EntityInterface* entity() const { return m_entity; }
+
+    bool supports(int feature);
+
+    /// Writes the attribute if the value differs from the last one written. Returns true if it was written, or
+    /// collected while held.
+    bool set(int attribute, const QVariant& value);
+
+    /// Last value written, invalid if the attribute was never written.
+    QVariant value(int attribute) const { return m_values.value(attribute); }
+
+    /// Forgets all written values, the next set() of every attribute is forwarded.
+    void clear();
+
+    /// Collects the writes until the matching release(). Holds nest, the outermost release forwards the changes.
+    void hold() { m_holds++; }
+    void release();
+    bool isHeld() const { return m_holds > 0; }
+
+ private:
+    void reset();
+
+    EntityInterface*     m_entity = nullptr;
+    SupportedFunction    m_isSupported;
+    UpdateFunction       m_update;
+    quint64              m_featuresKnown = 0;
+    quint64              m_featuresSupported = 0;
+    QVector<QVariant>    m_values;
+    int                  m_holds = 0;
+    QHash<int, QVariant> m_held;  // value the entity had before the first collected write
+};
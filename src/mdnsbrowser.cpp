@@ -0,0 +1,235 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "mdnsbrowser.h"
+
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QtEndian>
+
+static const quint16 MDNS_PORT = 5353;
+static const char    MDNS_GROUP[] = "224.0.0.251";
+static const quint16 CLASS_IN = 1;
+static const int     HEADER_SIZE = 12;
+
+static quint16 readUInt16(const QByteArray &message, int offset) {
+    return qFromBigEndian<quint16>(reinterpret_cast<const uchar *>(message.constData() + offset));
+}
+
+static void appendUInt16(QByteArray *message, quint16 value) {
+    message->append(static_cast<char>(value >> 8));
+    message->append(static_cast<char>(value & 0xff));
+}
+
+MdnsBrowser::MdnsBrowser(QObject *parent) : DiscoveryBackend(parent) {}
+
+void MdnsBrowser::browse(const QString &serviceType) {
+    if (!ensureSocket()) {
+        return;
+    }
+
+    m_serviceName = serviceType.toLower() + ".local";
+    // records are not kept across browses, a product moved by DHCP must not be reported at its old address
+    m_services.clear();
+    m_addresses.clear();
+    m_reported.clear();
+    m_asked.clear();
+    sendQuery({qMakePair(m_serviceName, static_cast<int>(TYPE_PTR))});
+}
+
+bool MdnsBrowser::ensureSocket() {
+    if (m_socket != nullptr) {
+        return true;
+    }
+
+    m_socket = new QUdpSocket(this);
+    // an ephemeral port, the responders answer by unicast
+    if (!m_socket->bind(QHostAddress::AnyIPv4, 0)) {
+        delete m_socket;
+        m_socket = nullptr;
+        return false;
+    }
+    m_socket->setSocketOption(QAbstractSocket::MulticastTtlOption, 255);
+    QObject::connect(m_socket, &QUdpSocket::readyRead, this, &MdnsBrowser::onReadyRead);
+    return true;
+}
+
+void MdnsBrowser::sendQuery(const QList<QPair<QString, int>> &questions) {
+    QByteArray message;
+    appendUInt16(&message, static_cast<quint16>(QRandomGenerator::global()->bounded(1, 0xffff)));  // id
+    appendUInt16(&message, 0);                                                                    // flags
+    appendUInt16(&message, static_cast<quint16>(questions.size()));
+    appendUInt16(&message, 0);
+    appendUInt16(&message, 0);
+    appendUInt16(&message, 0);
+    for (const auto &question : questions) {
+        appendName(&message, question.first);
+        appendUInt16(&message, static_cast<quint16>(question.second));
+        appendUInt16(&message, CLASS_IN);
+    }
+    m_socket->writeDatagram(message, QHostAddress(QString(MDNS_GROUP)), MDNS_PORT);
+}
+
+void MdnsBrowser::onReadyRead() {
+    while (m_socket->hasPendingDatagrams()) {
+        QByteArray message(static_cast<int>(m_socket->pendingDatagramSize()), Qt::Uninitialized);
+        m_socket->readDatagram(message.data(), message.size());
+        parseMessage(message);
+    }
+    resolve();
+}
+
+void MdnsBrowser::parseMessage(const QByteArray &message) {
+    // only responses
+    if (message.size() < HEADER_SIZE || !(readUInt16(message, 2) & 0x8000)) {
+        return;
+    }
+
+    int questions = readUInt16(message, 4);
+    int records = readUInt16(message, 6) + readUInt16(message, 8) + readUInt16(message, 10);
+    int offset = HEADER_SIZE;
+
+    QString name;
+    for (int i = 0; i < questions; i++) {
+        if (!readName(message, &offset, &name) || offset + 4 > message.size()) {
+            return;
+        }
+        offset += 4;
+    }
+
+    for (int i = 0; i < records; i++) {
+        if (!readName(message, &offset, &name) || offset + 10 > message.size()) {
+            return;
+        }
+        name = name.toLower();
+        int type = readUInt16(message, offset);
+        int length = readUInt16(message, offset + 8);
+        int data = offset + 10;
+        offset = data + length;
+        if (offset > message.size()) {
+            return;
+        }
+
+        if (type == TYPE_PTR && name == m_serviceName) {
+            QString instance;
+            int     dataOffset = data;
+            if (readName(message, &dataOffset, &instance)) {
+                m_services[instance.toLower()];
+            }
+        } else if (type == TYPE_SRV && name.endsWith(m_serviceName) && length > 6) {
+            Service &service = m_services[name];
+            service.port = readUInt16(message, data + 4);
+            int dataOffset = data + 6;
+            if (readName(message, &dataOffset, &service.host)) {
+                service.host = service.host.toLower();
+            }
+        } else if (type == TYPE_A && length == 4) {
+            m_addresses.insert(name, QHostAddress(qFromBigEndian<quint32>(
+                                         reinterpret_cast<const uchar *>(message.constData() + data))));
+        }
+    }
+}
+
+void MdnsBrowser::resolve() {
+    QList<QPair<QString, int>> questions;
+
+    for (auto iter = m_services.cbegin(); iter != m_services.cend(); ++iter) {
+        const QString &instance = iter.key();
+        const Service &service = iter.value();
+        if (m_reported.contains(instance)) {
+            continue;
+        }
+
+        if (service.host.isEmpty()) {
+            if (!m_asked.contains(instance)) {
+                m_asked.insert(instance);
+                questions.append(qMakePair(instance, static_cast<int>(TYPE_SRV)));
+            }
+        } else if (!m_addresses.contains(service.host)) {
+            if (!m_asked.contains(service.host)) {
+                m_asked.insert(service.host);
+                questions.append(qMakePair(service.host, static_cast<int>(TYPE_A)));
+            }
+        } else {
+            m_reported.insert(instance);
+            // the instance name without the service type, e.g. "Living room"
+            QString name = instance.left(instance.size() - m_serviceName.size() - 1);
+            emit serviceFound(name, m_addresses.value(service.host), service.port);
+        }
+    }
+
+    if (!questions.isEmpty()) {
+        sendQuery(questions);
+    }
+}
+
+void MdnsBrowser::appendName(QByteArray *message, const QString &name) {
+    // empty labels are skipped here, SkipEmptyParts moved from QString to Qt in Qt 5.14
+    const QStringList labels = name.split('.');
+    for (const QString &label : labels) {
+        if (label.isEmpty()) {
+            continue;
+        }
+        QByteArray utf8 = label.toUtf8().left(63);
+        message->append(static_cast<char>(utf8.size()));
+        message->append(utf8);
+    }
+    message->append('\0');
+}
+
+bool MdnsBrowser::readName(const QByteArray &message, int *offset, QString *name) {
+    QStringList labels;
+    int         position = *offset;
+    int         jumps = 0;
+    bool        jumped = false;
+
+    while (position < message.size()) {
+        quint8 length = static_cast<quint8>(message.at(position));
+        if (length == 0) {
+            if (!jumped) {
+                *offset = position + 1;
+            }
+            *name = labels.join('.');
+            return true;
+        }
+
+        if ((length & 0xc0) == 0xc0) {
+            // compression pointer, bounded against loops
+            if (position + 1 >= message.size() || ++jumps > 16) {
+                return false;
+            }
+            if (!jumped) {
+                *offset = position + 2;
+                jumped = true;
+            }
+            position = ((length & 0x3f) << 8) | static_cast<quint8>(message.at(position + 1));
+            continue;
+        }
+
+        if (position + 1 + length > message.size()) {
+            return false;
+        }
+        labels.append(QString::fromUtf8(message.constData() + position + 1, length));
+        position += 1 + length;
+    }
+    return false;
+}
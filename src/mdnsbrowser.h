@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QUdpSocket>
+
+#include "discoverybackend.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// MDNS BROWSER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Minimal multicast DNS service browser (RFC 6762, 6763).
+/// Queries are sent from an ephemeral port, so the responders answer by unicast (legacy unicast, RFC 6762 6.7) and
+/// port 5353 of a system responder is never needed. Instances whose address was not part of the answer are resolved
+/// with a follow-up SRV and A query.
+class MdnsBrowser : public DiscoveryBackend {
+    Q_OBJECT
+
+ public:
+    explicit MdnsBrowser(QObject* parent = nullptr);
+
+    void browse(const QString& serviceType) override;
+
+ private:
+    struct Service {
+        QString host;
+        quint16 port = 0;
+    };
+
+    enum RecordType { TYPE_A = 1, TYPE_PTR = 12, TYPE_TXT = 16, TYPE_SRV = 33 };
+
+    bool ensureSocket();
+    void sendQuery(const QList<QPair<QString, int>>& questions);
+    void onReadyRead();
+    void parseMessage(const QByteArray& message);
+    void resolve();
+
+    static void appendName(QByteArray* message, const QString& name);
+    static bool readName(const QByteArray& message, int* offset, QString* name);
+
+    QUdpSocket* m_socket = nullptr;
+    QString     m_serviceName;  // e.g. "_beoremote._tcp.local"
+
+    // collected from the answers of the current browse, instance name -> service, host name -> address
+    QHash<QString, Service>      m_services;
+    QHash<QString, QHostAddress> m_addresses;
+
+    // per browse, every instance is reported and every missing record asked for once
+    QSet<QString> m_reported;
+    QSet<QString> m_asked;
+};
@@ -0,0 +1,210 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "notificationdecoder.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+typedef void (*DecodeFunction)(const QJsonObject &data, BeoNotification *notification);
+
+struct NotificationTypeEntry {
+    BeoNotification::Type type;
+    DecodeFunction        decode;
+};
+
+static QString firstImageUrl(const QJsonObject &data, const QString &key) {
+    const QJsonArray images = data.value(key).toArray();
+    if (images.isEmpty()) {
+        return QString();
+    }
+    return images.first().toObject().value(QStringLiteral("url")).toString();
+}
+
+static void decodeVolume(const QJsonObject &data, BeoNotification *notification) {
+    NotificationDecoder::decodeVolume(data, &notification->volume);
+}
+
+static void decodeSource(const QJsonObject &data, BeoNotification *notification) {
+    NotificationDecoder::decodePrimaryExperience(data.value(QStringLiteral("primaryExperience")).toObject(),
+                                                 &notification->source);
+}
+
+static void decodeProgress(const QJsonObject &data, BeoNotification *notification) {
+    const QString state = data.value(QStringLiteral("state")).toString();
+    if (state == QLatin1String("play")) {
+        notification->progress.state = BeoProgress::PLAY;
+    } else if (state == QLatin1String("pause")) {
+        notification->progress.state = BeoProgress::PAUSE;
+    } else if (state == QLatin1String("stop")) {
+        notification->progress.state = BeoProgress::STOP;
+    }
+    notification->progress.position = data.value(QStringLiteral("position")).toInt();
+    notification->progress.duration = data.value(QStringLiteral("totalDuration")).toInt();
+}
+
+static void decodeStoredMusic(const QJsonObject &data, BeoNotification *notification) {
+    notification->music.imageUrl = firstImageUrl(data, QStringLiteral("trackImage"));
+    notification->music.artist = data.value(QStringLiteral("artist")).toString();
+    notification->music.title = data.value(QStringLiteral("name")).toString();
+    notification->music.album = data.value(QStringLiteral("album")).toString();
+}
+
+static void decodeNetRadio(const QJsonObject &data, BeoNotification *notification) {
+    notification->music.imageUrl = firstImageUrl(data, QStringLiteral("image"));
+    notification->music.artist = data.value(QStringLiteral("name")).toString();
+    notification->music.title = data.value(QStringLiteral("liveDescription")).toString();
+}
+
+static void decodeShutdown(const QJsonObject &data, BeoNotification *notification) {
+    Q_UNUSED(data)
+    notification->power.on = false;
+}
+
+static void decodeStandby(const QJsonObject &data, BeoNotification *notification) {
+    QJsonValue powerState = data.value(QStringLiteral("powerState"));
+    if (powerState.isUndefined()) {
+        powerState = data.value(QStringLiteral("standby")).toObject().value(QStringLiteral("powerState"));
+    }
+    notification->power.on = powerState.toString() == QLatin1String("on");
+}
+
+static inline int skipWhitespace(const char *data, int size, int position) {
+    while (position < size &&
+           (data[position] == ' ' || data[position] == '\t' || data[position] == '\r' || data[position] == '\n')) {
+        position++;
+    }
+    return position;
+}
+
+// built once, every notification is dispatched with a single hash lookup on its type
+static const QHash<QString, NotificationTypeEntry> &notificationTypes() {
+    static const QHash<QString, NotificationTypeEntry> types = {
+        {QStringLiteral("VOLUME"), {BeoNotification::VOLUME, &decodeVolume}},
+        {QStringLiteral("SOURCE"), {BeoNotification::SOURCE, &decodeSource}},
+        {QStringLiteral("PROGRESS_INFORMATION"), {BeoNotification::PROGRESS_INFORMATION, &decodeProgress}},
+        {QStringLiteral("NOW_PLAYING_STORED_MUSIC"), {BeoNotification::NOW_PLAYING_STORED_MUSIC, &decodeStoredMusic}},
+        {QStringLiteral("NOW_PLAYING_NET_RADIO"), {BeoNotification::NOW_PLAYING_NET_RADIO, &decodeNetRadio}},
+        {QStringLiteral("SHUTDOWN"), {BeoNotification::SHUTDOWN, &decodeShutdown}},
+        {QStringLiteral("STANDBY"), {BeoNotification::STANDBY, &decodeStandby}},
+    };
+    return types;
+}
+
+bool NotificationDecoder::decode(const QByteArray &frame, BeoNotification *notification, QString *errorString) {
+    *notification = BeoNotification();
+
+    QJsonParseError parseError;
+    QJsonDocument   doc = QJsonDocument::fromJson(frame, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        if (errorString) {
+            *errorString = parseError.errorString();
+        }
+        return false;
+    }
+
+    const QJsonObject object = doc.object().value(QStringLiteral("notification")).toObject();
+    const auto        entry = notificationTypes().constFind(object.value(QStringLiteral("type")).toString());
+    if (entry == notificationTypes().constEnd()) {
+        return true;
+    }
+
+    notification->type = entry->type;
+    entry->decode(object.value(QStringLiteral("data")).toObject(), notification);
+    return true;
+}
+
+void NotificationDecoder::decodeVolume(const QJsonObject &volume, BeoVolume *result) {
+    const QJsonObject speaker = volume.value(QStringLiteral("speaker")).toObject();
+    result->level = static_cast<int>(speaker.value(QStringLiteral("level")).toDouble(-1));
+    result->muted = speaker.value(QStringLiteral("muted")).toBool();
+}
+
+void NotificationDecoder::decodePrimaryExperience(const QJsonObject &primaryExperience, BeoSource *source) {
+    const QJsonObject sourceObject = primaryExperience.value(QStringLiteral("source")).toObject();
+    const QJsonObject product = sourceObject.value(QStringLiteral("product")).toObject();
+
+    source->friendlyName = sourceObject.value(QStringLiteral("friendlyName")).toString();
+    source->id = sourceObject.value(QStringLiteral("id")).toString();
+    source->productJid = product.value(QStringLiteral("jid")).toString();
+    source->productName = product.value(QStringLiteral("friendlyName")).toString();
+
+    source->listeners.clear();
+    const QJsonArray listeners = primaryExperience.value(QStringLiteral("listener")).toArray();
+    for (const QJsonValue &listener : listeners) {
+        source->listeners.append(listener.toString());
+    }
+}
+
+bool NotificationDecoder::peekType(const QByteArray &frame, BeoNotification::Type *type) {
+    const char *data = frame.constData();
+    const int   size = frame.size();
+    int         depth = 0;
+
+    for (int i = 0; i < size; i++) {
+        char c = data[i];
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            depth--;
+        } else if (c == '"') {
+            int start = ++i;
+            while (i < size && data[i] != '"') {
+                i += data[i] == '\\' ? 2 : 1;
+            }
+            if (i >= size) {
+                return false;
+            }
+
+            // {"notification": {"type": "..."}}, a "type" inside the data is one level deeper
+            if (depth != 2 || i - start != 4 || qstrncmp(data + start, "type", 4) != 0) {
+                continue;
+            }
+            int j = skipWhitespace(data, size, i + 1);
+            if (j >= size || data[j] != ':') {
+                // a value, not a key
+                continue;
+            }
+            j = skipWhitespace(data, size, j + 1);
+            if (j >= size || data[j] != '"') {
+                return false;
+            }
+            int valueStart = ++j;
+            while (j < size && data[j] != '"') {
+                j++;
+            }
+            if (j >= size) {
+                return false;
+            }
+            *type = typeFromString(QString::fromLatin1(data + valueStart, j - valueStart));
+            return true;
+        }
+    }
+    return false;
+}
+
+BeoNotification::Type NotificationDecoder::typeFromString(const QString &type) {
+    const auto entry = notificationTypes().constFind(type);
+    return entry == notificationTypes().constEnd() ? BeoNotification::UNKNOWN : entry->type;
+}
@@ -0,0 +1,114 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// NOTIFICATION TYPES
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct BeoVolume {
+    int  level = -1;
+    bool muted = false;
+};
+
+/// Source of the primary experience. Products playing the same source of the same product are grouped (BeoLink).
+struct BeoSource {
+    QString     friendlyName;
+    QString     id;
+    QString     productJid;
+    QString     productName;
+    QStringList listeners;
+
+    bool isGroupedWith(const BeoSource& other) const {
+        return !id.isEmpty() && id == other.id && productJid == other.productJid;
+    }
+};
+
+struct BeoProgress {
+    enum PlayState { UNKNOWN, PLAY, PAUSE, STOP };
+
+    PlayState state = UNKNOWN;
+    int       position = 0;
+    int       duration = 0;
+};
+
+struct BeoPower {
+    bool on = true;
+};
+
+struct BeoMusicInfo {
+    QString imageUrl;
+    QString artist;
+    QString title;
+    QString album;
+};
+
+/// One decoded notification of the /BeoNotify/Notifications stream. Only the part matching the type is filled.
+struct BeoNotification {
+    enum Type {
+        UNKNOWN,
+        VOLUME,
+        SOURCE,
+        PROGRESS_INFORMATION,
+        NOW_PLAYING_STORED_MUSIC,
+        NOW_PLAYING_NET_RADIO,
+        SHUTDOWN,
+        STANDBY
+    };
+
+    Type         type = UNKNOWN;
+    BeoVolume    volume;
+    BeoSource    source;
+    BeoProgress  progress;
+    BeoMusicInfo music;
+    BeoPower     power;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// NOTIFICATION DECODER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class NotificationDecoder {
+ public:
+    /// Decodes a single JSON frame. Returns false and sets errorString if the frame is not valid JSON.
+    /// Notifications of unhandled types are valid, they are returned with type UNKNOWN.
+    static bool decode(const QByteArray& frame, BeoNotification* notification, QString* errorString = nullptr);
+
+    /// Decodes the data of a VOLUME notification or the volume object of /BeoZone/Zone/Sound/Volume.
+    static void decodeVolume(const QJsonObject& volume, BeoVolume* result);
+
+    /// Decodes the primaryExperience object of a SOURCE notification or of /BeoZone/Zone/ActiveSources.
+    static void decodePrimaryExperience(const QJsonObject& primaryExperience, BeoSource* source);
+
+    /// Finds the type of a notification frame without decoding it, by scanning for the "type" key of the notification
+    /// object. Returns false if it was not found, the frame has to be decoded then.
+    static bool peekType(const QByteArray& frame, BeoNotification::Type* type);
+
+    /// Returns the notification type for the "type" string of the stream.
+    static BeoNotification::Type typeFromString(const QString& type);
+};
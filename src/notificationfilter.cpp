@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "notificationfilter.h"
+
+#include <algorithm>
+#include <limits>
+
+NotificationFilter::NotificationFilter() {
+    for (int type = 0; type < TYPE_COUNT; type++) {
+        m_lastAccepted[type] = std::numeric_limits<qint64>::min() / 2;
+    }
+    m_clock.start();
+}
+
+bool NotificationFilter::policyFromVariant(const QVariant &value, Policy *policy) {
+    QString text = value.toString();
+    bool    isNumber = false;
+    int     interval = text.toInt(&isNumber);
+
+    if (isNumber && interval > 0) {
+        policy->action = SAMPLE;
+        policy->interval = interval;
+    } else if (text == QLatin1String("latest")) {
+        policy->action = LATEST_ONLY;
+    } else if (text == QLatin1String("pass")) {
+        policy->action = PASS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void NotificationFilter::setPolicies(const Policies &policies, const FrameHandler &handler) {
+    QList<HeldFrame> released;
+    for (int type = 0; type < TYPE_COUNT; type++) {
+        m_policies[type] = policies.value(type);
+        if (m_policies[type].action != LATEST_ONLY && !m_held[type].frame.isNull()) {
+            released.append(m_held[type]);
+            m_held[type] = HeldFrame();
+        }
+    }
+    release(&released, handler);
+}
+
+bool NotificationFilter::accept(BeoNotification::Type type, const QByteArray &frame) {
+    const Policy &policy = m_policies[type];
+    switch (policy.action) {
+        case PASS:
+            return true;
+
+        case SAMPLE: {
+            qint64 now = m_clock.elapsed();
+            if (now - m_lastAccepted[type] < policy.interval) {
+                // the last frame of a burst must not be lost, it is decoded when the interval expired
+                hold(type, frame);
+                return false;
+            }
+            m_lastAccepted[type] = now;
+            m_held[type] = HeldFrame();
+            return true;
+        }
+
+        case LATEST_ONLY:
+            hold(type, frame);
+            return false;
+    }
+    return true;
+}
+
+qint64 NotificationFilter::msecsToRelease() const {
+    qint64 now = m_clock.elapsed();
+    qint64 next = -1;
+    for (int type = 0; type < TYPE_COUNT; type++) {
+        if (m_policies[type].action == SAMPLE && !m_held[type].frame.isNull()) {
+            qint64 due = qMax(Q_INT64_C(0), m_lastAccepted[type] + m_policies[type].interval - now);
+            next = next < 0 ? due : qMin(next, due);
+        }
+    }
+    return next;
+}
+
+void NotificationFilter::releaseDue(const FrameHandler &handler) {
+    qint64           now = m_clock.elapsed();
+    QList<HeldFrame> released;
+    for (int type = 0; type < TYPE_COUNT; type++) {
+        if (m_policies[type].action == SAMPLE && !m_held[type].frame.isNull() &&
+            now - m_lastAccepted[type] >= m_policies[type].interval) {
+            m_lastAccepted[type] = now;
+            released.append(m_held[type]);
+            m_held[type] = HeldFrame();
+        }
+    }
+    release(&released, handler);
+}
+
+void NotificationFilter::hold(BeoNotification::Type type, const QByteArray &frame) {
+    // the frame only references the stream buffer
+    m_held[type].sequence = m_sequence++;
+    m_held[type].frame = QByteArray(frame.constData(), frame.size());
+}
+
+void NotificationFilter::release(QList<HeldFrame> *frames, const FrameHandler &handler) {
+    std::sort(frames->begin(), frames->end(),
+              [](const HeldFrame &a, const HeldFrame &b) { return a.sequence < b.sequence; });
+    for (const HeldFrame &held : *frames) {
+        handler(held.frame);
+    }
+}
+
+void NotificationFilter::clear() {
+    for (int type = 0; type < TYPE_COUNT; type++) {
+        m_held[type] = HeldFrame();
+    }
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+#include <functional>
+
+#include "notificationdecoder.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// NOTIFICATION FILTER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Decides per notification type whether a frame is decoded now, before any JSON decoding.
+/// PASS decodes every frame, SAMPLE at most one per interval and holds back the newest of the others until the
+/// interval expired, LATEST_ONLY holds back the newest frame until the type is passed again, e.g. when the player
+/// becomes visible.
+/// The filter has no timer, the owner calls releaseDue() after msecsToRelease().
+class NotificationFilter {
+ public:
+    enum Action { PASS, SAMPLE, LATEST_ONLY };
+
+    struct Policy {
+        Action action = PASS;
+        int    interval = 0;  // SAMPLE only, in ms
+    };
+
+    typedef QHash<int, Policy>                           Policies;  // by BeoNotification::Type, missing types pass
+    typedef std::function<void(const QByteArray& frame)> FrameHandler;
+
+    NotificationFilter();
+
+    /// Parses "pass", "latest" or a sample interval in ms.
+    static bool policyFromVariant(const QVariant& value, Policy* policy);
+
+    /// Replaces all policies. Held frames of types that are no longer LATEST_ONLY are handed to handler, oldest first.
+    void setPolicies(const Policies& policies, const FrameHandler& handler);
+
+    /// Returns true if the frame is to be decoded now. A held frame is copied.
+    bool accept(BeoNotification::Type type, const QByteArray& frame);
+
+    /// Time until the next sampled frame is due in ms, or -1 if no sampled frame is held.
+    qint64 msecsToRelease() const;
+
+    /// Hands the sampled frames whose interval expired to handler, oldest first.
+    void releaseDue(const FrameHandler& handler);
+
+    /// Forgets the held frames, e.g. after a reconnect.
+    void clear();
+
+ private:
+    static const int TYPE_COUNT = BeoNotification::STANDBY + 1;
+
+    struct HeldFrame {
+        quint64    sequence = 0;
+        QByteArray frame;
+    };
+
+    void hold(BeoNotification::Type type, const QByteArray& frame);
+    void release(QList<HeldFrame>* frames, const FrameHandler& handler);
+
+    Policy        m_policies[TYPE_COUNT];
+    qint64        m_lastAccepted[TYPE_COUNT];
+    HeldFrame     m_held[TYPE_COUNT];
+    quint64       m_sequence = 0;
+    QElapsedTimer m_clock;
+};
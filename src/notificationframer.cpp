@@ -0,0 +1,88 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "notificationframer.h"
+
+static const char FRAME_DELIMITER[] = "\r\n\r\n";
+static const int  FRAME_DELIMITER_LENGTH = 4;
+
+static inline bool isJsonWhitespace(char c) { return c == ' ' || c == '\r' || c == '\n' || c == '\t'; }
+
+NotificationFramer::NotificationFramer(int maxBufferSize) : m_maxBufferSize(maxBufferSize) {}
+
+bool NotificationFramer::feed(const QByteArray &data, const FrameHandler &handler) {
+    if (m_buffer.isEmpty()) {
+        // implicitly shared, no copy of the network data
+        m_buffer = data;
+    } else {
+        m_buffer.append(data);
+    }
+
+    // keep a reference so the data stays valid if the handler clears the framer
+    QByteArray  buffer = m_buffer;
+    const char *raw = buffer.constData();
+    int         start = 0;
+    int         end;
+    m_cleared = false;
+
+    while (!m_cleared && (end = buffer.indexOf(FRAME_DELIMITER, m_scanFrom)) != -1) {
+        int first = start;
+        int last = end;
+        while (first < last && isJsonWhitespace(raw[first])) {
+            first++;
+        }
+        while (last > first && isJsonWhitespace(raw[last - 1])) {
+            last--;
+        }
+        if (last > first) {
+            handler(QByteArray::fromRawData(raw + first, last - first));
+        }
+        start = end + FRAME_DELIMITER_LENGTH;
+        m_scanFrom = start;
+    }
+
+    // release our reference before modifying the buffer, otherwise it would be detached
+    buffer.clear();
+
+    if (m_cleared) {
+        return true;
+    }
+
+    if (start > 0) {
+        m_buffer.remove(0, start);
+    }
+    // a delimiter may be split over two reads
+    m_scanFrom = qMax(0, m_buffer.size() - (FRAME_DELIMITER_LENGTH - 1));
+
+    if (m_buffer.size() > m_maxBufferSize) {
+        m_overflowCount++;
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void NotificationFramer::clear() {
+    m_buffer.clear();
+    m_scanFrom = 0;
+    m_cleared = true;
+}
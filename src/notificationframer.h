@@ -0,0 +1,60 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// NOTIFICATION FRAMER
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Splits the raw /BeoNotify/Notifications byte stream into single JSON frames.
+/// Frames are separated by an empty line ("\r\n\r\n"). Incomplete frames are kept until the next read.
+class NotificationFramer {
+ public:
+    typedef std::function<void(const QByteArray& frame)> FrameHandler;
+
+    static const int DEFAULT_MAX_BUFFER_SIZE = 256 * 1024;
+
+    explicit NotificationFramer(int maxBufferSize = DEFAULT_MAX_BUFFER_SIZE);
+
+    /// Appends data read from the stream and calls handler for every complete frame.
+    /// The frame passed to the handler references the internal buffer and is only valid during the call.
+    /// Returns false if the pending data exceeded the buffer limit and had to be dropped.
+    bool feed(const QByteArray& data, const FrameHandler& handler);
+
+    /// Drops any pending partial frame, e.g. after a reconnect.
+    void clear();
+
+    int pendingBytes() const { return m_buffer.size(); }
+    int overflowCount() const { return m_overflowCount; }
+
+ private:
+    QByteArray m_buffer;
+    int        m_maxBufferSize;
+    int        m_scanFrom = 0;  // the delimiter search resumes here, data before cannot contain a frame end
+    int        m_overflowCount = 0;
+    bool       m_cleared = false;
+};
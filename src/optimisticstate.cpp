@@ -0,0 +1,99 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "optimisticstate.h"
+
+#include <QList>
+
+OptimisticState::OptimisticState(const ReadFunction &read, const WriteFunction &write) : m_read(read), m_write(write) {}
+
+void OptimisticState::propose(int attribute, const QVariant &value) {
+    auto iter = m_pending.find(attribute);
+    if (iter == m_pending.end()) {
+        iter = m_pending.insert(attribute, Pending());
+        iter->reported = m_read(attribute);
+    }
+    iter->value = value;
+    iter->commands++;
+    iter->settleAt = -1;
+    m_write(attribute, value);
+}
+
+void OptimisticState::commandDone(int attribute, bool success, qint64 now) {
+    auto iter = m_pending.find(attribute);
+    if (iter == m_pending.end()) {
+        return;
+    }
+    iter->commands--;
+
+    if (!success) {
+        rollback(attribute);
+    } else if (iter->commands <= 0) {
+        if (iter->reported == iter->value) {
+            // the notification was faster than the answer
+            m_pending.erase(iter);
+        } else {
+            // the product accepted it, the notification is on its way
+            iter->settleAt = now + SETTLE_TIME;
+        }
+    }
+}
+
+bool OptimisticState::report(int attribute, const QVariant &value) {
+    auto iter = m_pending.find(attribute);
+    if (iter == m_pending.end()) {
+        return m_write(attribute, value);
+    }
+
+    iter->reported = value;
+    if (value == iter->value && iter->commands <= 0) {
+        m_pending.erase(iter);
+        return m_write(attribute, value);
+    }
+    return false;
+}
+
+qint64 OptimisticState::settle(qint64 now) {
+    qint64     next = -1;
+    QList<int> due;
+    for (auto iter = m_pending.cbegin(); iter != m_pending.cend(); ++iter) {
+        if (iter->settleAt < 0) {
+            continue;
+        }
+        if (iter->settleAt <= now) {
+            due.append(iter.key());
+        } else if (next < 0 || iter->settleAt - now < next) {
+            next = iter->settleAt - now;
+        }
+    }
+    for (int attribute : due) {
+        rollback(attribute);
+    }
+    return next;
+}
+
+void OptimisticState::rollback(int attribute) {
+    Pending pending = m_pending.take(attribute);
+    if (pending.reported.isValid()) {
+        m_write(attribute, pending.reported);
+    }
+}
@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QVariant>
+
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// OPTIMISTIC STATE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Shows the effect of a command on the entity as soon as it is sent, before the product reports it.
+/// While a proposed value is pending, values reported by the product are only remembered: the one equal to the
+/// proposal confirms it, others are intermediate steps and would make the entity flip-flop. A failed command rolls back
+/// to the last reported value. If a sent command is never confirmed, the last reported value wins after SETTLE_TIME.
+/// The entity is read and written through the given functions, usually those of an EntityShadow.
+class OptimisticState {
+ public:
+    typedef std::function<QVariant(int attribute)>                    ReadFunction;
+    typedef std::function<bool(int attribute, const QVariant& value)> WriteFunction;
+
+    static const int SETTLE_TIME = 3000;
+
+    OptimisticState(const ReadFunction& read, const WriteFunction& write);
+
+    /// A command setting attribute to value is sent.
+    void propose(int attribute, const QVariant& value);
+
+    /// The command of a proposed value was answered. Times are in ms of any monotonic clock.
+    void commandDone(int attribute, bool success, qint64 now);
+
+    /// A value reported by the product. Returns true if it was written to the entity.
+    bool report(int attribute, const QVariant& value);
+
+    /// Settles the pending values that were not confirmed in time. Returns the ms until the next one is due, or -1.
+    qint64 settle(qint64 now);
+
+    bool     isPending(int attribute) const { return m_pending.contains(attribute); }
+    QVariant pendingValue(int attribute) const { return m_pending.value(attribute).value; }
+
+    /// Forgets the pending values, the entity keeps what it shows.
+    void clear() { m_pending.clear(); }
+
+ private:
+    struct Pending {
+        QVariant value;
+        QVariant reported;  // last value reported by the product
+        int      commands = 0;
+        qint64   settleAt = -1;
+    };
+
+    void rollback(int attribute);
+
+    ReadFunction        m_read;
+    WriteFunction       m_write;
+    QHash<int, Pending> m_pending;
+};
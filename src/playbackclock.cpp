@@ -0,0 +1,47 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "playbackclock.h"
+
+void PlaybackClock::anchor(qint64 position, qint64 duration, bool playing, qint64 now) {
+    m_valid = true;
+    m_playing = playing;
+    m_position = position;
+    m_duration = duration;
+    m_anchoredAt = now;
+}
+
+void PlaybackClock::clear() {
+    m_valid = false;
+    m_playing = false;
+    m_position = 0;
+    m_duration = 0;
+}
+
+qint64 PlaybackClock::position(qint64 now) const {
+    if (!m_playing) {
+        return m_position;
+    }
+
+    qint64 position = m_position + qMax<qint64>(0, now - m_anchoredAt);
+    return m_duration > 0 ? qMin(position, m_duration) : position;
+}
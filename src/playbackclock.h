@@ -0,0 +1,51 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QtGlobal>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PLAYBACK CLOCK
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Local playback position, anchored on the last reported position and extrapolated while playing.
+/// All times are in ms, now is any monotonic clock, e.g. a QElapsedTimer.
+class PlaybackClock {
+ public:
+    void anchor(qint64 position, qint64 duration, bool playing, qint64 now);
+    void clear();
+
+    bool   isValid() const { return m_valid; }
+    bool   isPlaying() const { return m_valid && m_playing; }
+    qint64 duration() const { return m_duration; }
+
+    /// Extrapolated position, never beyond the duration if it is known.
+    qint64 position(qint64 now) const;
+
+ private:
+    bool   m_valid = false;
+    bool   m_playing = false;
+    qint64 m_position = 0;
+    qint64 m_duration = 0;
+    qint64 m_anchoredAt = 0;
+};
@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "productdiscovery.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QUrl>
+
+static const char SERVICE_TYPE[] = "_beoremote._tcp";
+
+ProductDiscovery::ProductDiscovery(DiscoveryBackend *backend, QNetworkAccessManager *manager, QObject *parent)
+    : QObject(parent), m_backend(backend), m_manager(manager) {
+    m_backend->setParent(this);
+    QObject::connect(m_backend, &DiscoveryBackend::serviceFound, this, &ProductDiscovery::onServiceFound);
+
+    m_browseTimer = new QTimer(this);
+    m_browseTimer->setInterval(BROWSE_INTERVAL);
+    QObject::connect(m_browseTimer, &QTimer::timeout, this, &ProductDiscovery::refresh);
+}
+
+ProductDiscovery::~ProductDiscovery() {
+    for (QNetworkReply *reply : m_probes) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+void ProductDiscovery::start() {
+    m_browseTimer->start();
+    refresh();
+}
+
+void ProductDiscovery::stop() {
+    m_browseTimer->stop();
+    // products found by the probes are not taken any more
+    for (QNetworkReply *reply : m_probes) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+    m_probes.clear();
+}
+
+void ProductDiscovery::refresh() {
+    m_backend->browse(SERVICE_TYPE);
+}
+
+void ProductDiscovery::onServiceFound(const QString &name, const QHostAddress &address, quint16 port) {
+    Q_UNUSED(name)
+    QString host = address.protocol() == QAbstractSocket::IPv6Protocol ? QString("[%1]").arg(address.toString())
+                                                                         : address.toString();
+    QString hostAndPort = QString("%1:%2").arg(host).arg(port);
+    if (m_probes.contains(hostAndPort)) {
+        return;
+    }
+
+    QNetworkReply *reply = m_manager->get(QNetworkRequest(QUrl(QString("http://%1/BeoDevice").arg(hostAndPort))));
+    m_probes.insert(hostAndPort, reply);
+    QObject::connect(reply, &QNetworkReply::finished, this, [=]() { onProbeFinished(hostAndPort, reply); });
+    QTimer::singleShot(PROBE_TIMEOUT, reply, &QNetworkReply::abort);
+}
+
+void ProductDiscovery::onProbeFinished(const QString &address, QNetworkReply *reply) {
+    m_probes.remove(address);
+    reply->deleteLater();
+    if (reply->error() != QNetworkReply::NoError) {
+        return;
+    }
+
+    const QJsonObject device = QJsonDocument::fromJson(reply->readAll()).object().value("beoDevice").toObject();
+
+    BeoProductInfo product;
+    product.serialNumber = device.value("productId").toObject().value("serialNumber").toString();
+    product.friendlyName = device.value("productFriendlyName").toObject().value("productFriendlyName").toString();
+    product.address = address;
+    if (!product.serialNumber.isEmpty()) {
+        emit productFound(product);
+    }
+}
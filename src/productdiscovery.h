@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QHostAddress>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include "discoverybackend.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// PRODUCT DISCOVERY
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Identity of a discovered Bang & Olufsen product.
+struct BeoProductInfo {
+    QString serialNumber;
+    QString friendlyName;
+    QString address;  // host:port of the REST API
+};
+
+/// Browses for _beoremote._tcp products and asks each one for its identity (/BeoDevice).
+/// All candidates of a search are probed at the same time, a slow or dead one does not hold up the others.
+class ProductDiscovery : public QObject {
+    Q_OBJECT
+
+ public:
+    static const int PROBE_TIMEOUT = 3000;
+    static const int BROWSE_INTERVAL = 5 * 60 * 1000;
+
+    /// Takes ownership of backend.
+    ProductDiscovery(DiscoveryBackend* backend, QNetworkAccessManager* manager, QObject* parent = nullptr);
+    ~ProductDiscovery() override;
+
+    /// Browses now and then every BROWSE_INTERVAL.
+    void start();
+    /// Stops browsing and aborts the running probes.
+    void stop();
+
+    /// Browses now, e.g. when a product cannot be reached at its address.
+    void refresh();
+
+ signals:
+    void productFound(const BeoProductInfo& product);
+
+ private:
+    void onServiceFound(const QString& name, const QHostAddress& address, quint16 port);
+    void onProbeFinished(const QString& address, QNetworkReply* reply);
+
+    DiscoveryBackend*      m_backend;
+    QNetworkAccessManager* m_manager;
+    QTimer*                m_browseTimer;
+
+    // address -> probe in flight
+    QHash<QString, QNetworkReply*> m_probes;
+};
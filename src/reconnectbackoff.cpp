@@ -0,0 +1,44 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "reconnectbackoff.h"
+
+#include <QRandomGenerator>
+#include <QtGlobal>
+
+ReconnectBackoff::ReconnectBackoff(int initialDelay, int maxDelay, double jitter)
+    : m_initialDelay(initialDelay), m_maxDelay(maxDelay), m_jitter(jitter), m_delay(initialDelay) {}
+
+int ReconnectBackoff::nextDelay() {
+    int base = m_delay;
+    m_delay = qMin(m_delay * 2, m_maxDelay);
+    m_attempts++;
+
+    // +/- jitter around the base delay
+    double factor = 1.0 + m_jitter * (2.0 * QRandomGenerator::global()->generateDouble() - 1.0);
+    return qMax(0, static_cast<int>(base * factor));
+}
+
+void ReconnectBackoff::reset() {
+    m_delay = m_initialDelay;
+    m_attempts = 0;
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// RECONNECT BACKOFF
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Capped exponential backoff with random jitter for reconnect attempts.
+/// The jitter spreads the reconnects of several products that dropped at the same time.
+class ReconnectBackoff {
+ public:
+    explicit ReconnectBackoff(int initialDelay = 1000, int maxDelay = 60000, double jitter = 0.2);
+
+    /// Delay in ms before the next attempt. Every call doubles the base delay up to the maximum.
+    int nextDelay();
+
+    void reset();
+
+    int attempts() const { return m_attempts; }
+
+ private:
+    int    m_initialDelay;
+    int    m_maxDelay;
+    double m_jitter;
+    int    m_delay;
+    int    m_attempts = 0;
+};
@@ -0,0 +1,13 @@
+# Benchmarks of the notification ingest and of command round trips, run with "make benchmark".
+# QtTest writes machine-readable results, e.g.
+#   ./tst_benchmark -o results.xml,xml -o -,txt
+#   ./tst_benchmark -o results.csv,csv
+# and -iterations, -median or -callgrind tune the measurement.
+include(../tests.pri)
+include(../beodevice.pri)
+
+# not part of "make check"
+CONFIG   += benchmark
+
+TARGET    = tst_benchmark
+SOURCES  += tst_benchmark.cpp
@@ -0,0 +1,197 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QDir>
+#include <QLoggingCategory>
+#include <QNetworkProxy>
+#include <QtTest>
+
+#include "beodevice.h"
+#include "beostandin.h"
+#include "notificationtrace.h"
+#include "yio-interface/entities/mediaplayerinterface.h"
+
+Q_LOGGING_CATEGORY(lcBenchmark, "yio.intg.bangolufsen.benchmark")
+
+/// Notification ingest and command round trips of one product, measured with QBENCHMARK.
+/// The product has no entity, what is measured is the integration: framing, filtering, decoding, tracking.
+class TestBenchmark : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+
+    void ingest_data();
+    void ingest();
+
+    void roundTrip_data();
+    void roundTrip();
+
+ private:
+    static void attachEntity(BeoDevice *device);
+    quint64     parsedFrames(BeoDevice *device) const;
+
+    QHash<QString, QList<QByteArray>> m_frames;  // recorded frames by type
+    QList<QByteArray>                 m_traces;  // whole traces, in the order they were recorded
+    QStringList                       m_traceNames;
+};
+
+// every ingest row feeds the same number of frames, the results of the rows compare directly
+static const int FRAMES_PER_ROW = 1000;
+
+void TestBenchmark::initTestCase() {
+    // a warning per frame would be measured as well
+    QLoggingCategory::setFilterRules("yio.intg.bangolufsen.*=false");
+
+    const QStringList files = QDir(TRACE_DIR).entryList({"*.trace"}, QDir::Files);
+    for (const QString &file : files) {
+        QList<TraceEntry> trace;
+        QString           errorString;
+        QVERIFY2(NotificationTrace::load(QDir(TRACE_DIR).filePath(file), &trace, &errorString),
+                 qPrintable(errorString));
+
+        QByteArray stream;
+        for (const TraceEntry &entry : trace) {
+            m_frames[NotificationTrace::typeOf(entry.frame)].append(entry.frame);
+            stream.append(entry.frame + "\r\n\r\n");
+        }
+        m_traces.append(stream);
+        m_traceNames.append(file);
+    }
+    QVERIFY(!m_traces.isEmpty());
+}
+
+void TestBenchmark::ingest_data() {
+    QTest::addColumn<QByteArray>("stream");
+    QTest::addColumn<int>("pieceSize");
+    QTest::addColumn<bool>("hidden");
+
+    // the recorded frames of one type, repeated up to the same count
+    for (auto iter = m_frames.cbegin(); iter != m_frames.cend(); ++iter) {
+        QByteArray stream;
+        for (int i = 0; i < FRAMES_PER_ROW; i++) {
+            stream.append(iter.value().at(i % iter.value().size()) + "\r\n\r\n");
+        }
+        QTest::newRow(qPrintable(iter.key())) << stream << 0 << false;
+    }
+
+    // whole sessions as one read, in the pieces of a slow network and with the player not visible
+    for (int i = 0; i < m_traces.size(); i++) {
+        const QString name = m_traceNames.at(i);
+        QTest::newRow(qPrintable(name)) << m_traces.at(i) << 0 << false;
+        QTest::newRow(qPrintable(name + " 512 byte reads")) << m_traces.at(i) << 512 << false;
+        QTest::newRow(qPrintable(name + " hidden")) << m_traces.at(i) << 0 << true;
+    }
+}
+
+void TestBenchmark::ingest() {
+    QFETCH(QByteArray, stream);
+    QFETCH(int, pieceSize);
+    QFETCH(bool, hidden);
+
+    QNetworkAccessManager manager;
+    BeoDevice device("127.0.0.1:1", "media_player.benchmark", &manager, nullptr, nullptr, lcBenchmark());
+    attachEntity(&device);
+    if (hidden) {
+        // the default policies of a player that is not shown
+        NotificationFilter::Policy latest;
+        latest.action = NotificationFilter::LATEST_ONLY;
+        NotificationFilter::Policies policies;
+        policies.insert(BeoNotification::PROGRESS_INFORMATION, latest);
+        policies.insert(BeoNotification::NOW_PLAYING_STORED_MUSIC, latest);
+        policies.insert(BeoNotification::NOW_PLAYING_NET_RADIO, latest);
+        device.setNotificationPolicies(policies);
+    }
+
+    // the pieces are cut before, only the ingest is measured
+    QList<QByteArray> pieces;
+    if (pieceSize > 0) {
+        for (int i = 0; i < stream.size(); i += pieceSize) {
+            pieces.append(stream.mid(i, pieceSize));
+        }
+    } else {
+        pieces.append(stream);
+    }
+
+    QBENCHMARK {
+        for (const QByteArray &piece : pieces) {
+            device.feedStream(piece);
+        }
+    }
+    QVERIFY(parsedFrames(&device) > 0 || hidden);
+}
+
+void TestBenchmark::roundTrip_data() {
+    QTest::addColumn<int>("command");
+    QTest::addColumn<bool>("fromStandby");
+
+    QTest::newRow("Play") << static_cast<int>(MediaPlayerDef::C_PLAY) << false;
+    QTest::newRow("setVolume") << static_cast<int>(MediaPlayerDef::C_VOLUME_SET) << false;
+    QTest::newRow("TurnOn") << static_cast<int>(MediaPlayerDef::C_TURNON) << true;
+}
+
+void TestBenchmark::roundTrip() {
+    QFETCH(int, command);
+    QFETCH(bool, fromStandby);
+
+    BeoStandIn standIn;
+    QVERIFY(standIn.listen());
+    QNetworkAccessManager manager;
+    manager.setProxy(QNetworkProxy::NoProxy);
+    BeoDevice device(standIn.address(), "media_player.benchmark", &manager, nullptr, nullptr, lcBenchmark());
+    attachEntity(&device);
+    device.connectToDevice();
+    QTRY_VERIFY(device.isConnected());
+
+    // from sending the command until the product answered it and notified the change on the stream
+    int volume = 20;
+    QBENCHMARK {
+        if (fromStandby) {
+            standIn.setOn(false);
+        }
+        volume = volume == 20 ? 21 : 20;
+
+        bool    answered = false;
+        bool    success = false;
+        quint64 frames = parsedFrames(&device);
+        device.sendCommand(command, volume, [&](bool ok) {
+            answered = true;
+            success = ok;
+        });
+        QVERIFY(QTest::qWaitFor([&]() { return answered && parsedFrames(&device) > frames; }, 5000));
+        QVERIFY(success);
+    }
+    device.disconnectFromDevice();
+}
+
+void TestBenchmark::attachEntity(BeoDevice *device) {
+    // an entity that supports every feature and ignores the writes, so the cost up to the entity update is measured:
+    // shadow, optimistic state and playback clock. The artwork is shown from its URL, no download is measured.
+    device->attachEntity([](int) { return true; }, [](int, const QVariant &) {});
+}
+
+quint64 TestBenchmark::parsedFrames(BeoDevice *device) const {
+    return device->metrics().value("parsing").toMap().value("frames").toULongLong();
+}
+
+QTEST_GUILESS_MAIN(TestBenchmark)
+#include "tst_benchmark.moc"
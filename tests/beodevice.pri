@@ -0,0 +1,37 @@
+# BeoDevice and the components it is built from, for the tests that drive whole products.
+# BeoDevice uses the YIO interfaces of the integrations.library project.
+QT       += gui quick websockets
+
+include($$PWD/integrations.pri)
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file!" )
+}
+
+HEADERS  += $$SRC_PATH/artworkcache.h \
+            $$SRC_PATH/beodevice.h \
+            $$SRC_PATH/beohttpclient.h \
+            $$SRC_PATH/beometrics.h \
+            $$SRC_PATH/commandcoalescer.h \
+            $$SRC_PATH/contentcache.h \
+            $$SRC_PATH/deviceprofile.h \
+            $$SRC_PATH/entityshadow.h \
+            $$SRC_PATH/notificationdecoder.h \
+            $$SRC_PATH/notificationfilter.h \
+            $$SRC_PATH/notificationframer.h \
+            $$SRC_PATH/optimisticstate.h \
+            $$SRC_PATH/playbackclock.h \
+            $$SRC_PATH/reconnectbackoff.h
+SOURCES  += $$SRC_PATH/artworkcache.cpp \
+            $$SRC_PATH/beodevice.cpp \
+            $$SRC_PATH/beohttpclient.cpp \
+            $$SRC_PATH/beometrics.cpp \
+            $$SRC_PATH/commandcoalescer.cpp \
+            $$SRC_PATH/contentcache.cpp \
+            $$SRC_PATH/deviceprofile.cpp \
+            $$SRC_PATH/entityshadow.cpp \
+            $$SRC_PATH/notificationdecoder.cpp \
+            $$SRC_PATH/notificationfilter.cpp \
+            $$SRC_PATH/notificationframer.cpp \
+            $$SRC_PATH/optimisticstate.cpp \
+            $$SRC_PATH/playbackclock.cpp \
+            $$SRC_PATH/reconnectbackoff.cpp
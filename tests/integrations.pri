@@ -0,0 +1,7 @@
+# Location of the integrations.library project, found like for the plugin
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../integrations.library)
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+}
@@ -0,0 +1,18 @@
+# Soak test: several products against stand-ins with random commands, polls, replays, stalls, disconnects and
+# standby cycles.
+# Fails if the resident memory, the number of live QObjects or the number of network replies grows.
+# Run with "make soak", the length is set with SOAK_ITERATIONS, e.g. SOAK_ITERATIONS=20000 make soak.
+include(../tests.pri)
+include(../beodevice.pri)
+
+# live QObjects are counted through the hooks of QtCore
+QT       += core-private
+
+TARGET    = tst_soak
+SOURCES  += tst_soak.cpp
+
+# not part of "make check", a meaningful run takes a while
+CONFIG   -= testcase
+soak.commands = $$shell_path($$OUT_PWD/$$TARGET)
+soak.depends = first
+QMAKE_EXTRA_TARGETS += soak
@@ -0,0 +1,333 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QDir>
+#include <QLoggingCategory>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <private/qhooks_p.h>
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+#include "artworkcache.h"
+#include "beodevice.h"
+#include "beostandin.h"
+#include "notificationtrace.h"
+#include "yio-interface/entities/mediaplayerinterface.h"
+
+Q_LOGGING_CATEGORY(lcSoak, "yio.intg.bangolufsen.soak")
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// RESOURCE USAGE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::atomic<int> g_liveObjects(0);
+static quintptr         g_previousAddHook = 0;
+static quintptr         g_previousRemoveHook = 0;
+
+static void onAddQObject(QObject *object) {
+    g_liveObjects++;
+    if (g_previousAddHook) {
+        reinterpret_cast<QHooks::AddQObjectCallback>(g_previousAddHook)(object);
+    }
+}
+
+static void onRemoveQObject(QObject *object) {
+    g_liveObjects--;
+    if (g_previousRemoveHook) {
+        reinterpret_cast<QHooks::RemoveQObjectCallback>(g_previousRemoveHook)(object);
+    }
+}
+
+/// Resident memory, live QObjects of all threads and open network replies.
+struct Usage {
+    qint64 rssKb = -1;  // -1 where it cannot be read
+    int    objects = 0;
+    int    replies = 0;
+
+    static Usage measure(QNetworkAccessManager *manager) {
+        Usage usage;
+#ifdef Q_OS_LINUX
+        QFile statm("/proc/self/statm");
+        if (statm.open(QIODevice::ReadOnly)) {
+            // size and resident set in pages
+            const QList<QByteArray> fields = statm.readAll().split(' ');
+            if (fields.size() > 1) {
+                usage.rssKb = fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+            }
+        }
+#endif
+        usage.objects = g_liveObjects;
+        usage.replies = manager->findChildren<QNetworkReply *>(QString(), Qt::FindDirectChildrenOnly).size();
+        return usage;
+    }
+};
+
+static int environment(const char *name, int defaultValue) {
+    bool ok = false;
+    int  value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// SOAK TEST
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class TestSoak : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void soak();
+
+ private:
+    void step(int index);
+    void settle();
+
+    // tolerated growth over the whole run, e.g. idle connections kept by the network access manager
+    static const int RSS_SLACK_KB = 4096;
+    static const int OBJECT_SLACK = 64;
+
+    // a quiet stream is checked with a standby query after this time, instead of 30 s
+    static const int STREAM_IDLE_TIMEOUT = 300;
+
+    QRandomGenerator       m_random;
+    QNetworkAccessManager *m_manager = nullptr;
+    QTemporaryDir          m_artworkDirectory;
+    ArtworkCache *         m_artwork = nullptr;
+    QList<BeoStandIn *>    m_standIns;
+    QList<BeoDevice *>     m_devices;
+    QList<TraceEntry>      m_trace;
+
+    // the entities of the products, written through their shadows
+    QList<QHash<int, QVariant>> m_entities;
+    quint64                     m_entityUpdates = 0;
+};
+
+void TestSoak::initTestCase() {
+    QLoggingCategory::setFilterRules("yio.intg.bangolufsen.*=false");
+
+    g_previousAddHook = qtHookData[QHooks::AddQObject];
+    g_previousRemoveHook = qtHookData[QHooks::RemoveQObject];
+    qtHookData[QHooks::AddQObject] = reinterpret_cast<quintptr>(&onAddQObject);
+    qtHookData[QHooks::RemoveQObject] = reinterpret_cast<quintptr>(&onRemoveQObject);
+
+    m_random.seed(static_cast<quint32>(environment("SOAK_SEED", 1)));
+    QVERIFY(NotificationTrace::load(QDir(TRACE_DIR).filePath("playback.trace"), &m_trace));
+
+    m_manager = new QNetworkAccessManager(this);
+    m_manager->setProxy(QNetworkProxy::NoProxy);
+    QVERIFY(m_artworkDirectory.isValid());
+    m_artwork = new ArtworkCache(m_manager, m_artworkDirectory.path(), ArtworkCache::DEFAULT_IMAGE_SIZE,
+                                 ArtworkCache::DEFAULT_DISK_SIZE, this);
+
+    const int devices = environment("SOAK_DEVICES", 3);
+    m_entities.reserve(devices);
+    for (int i = 0; i < devices; i++) {
+        BeoStandIn *standIn = new BeoStandIn(this);
+        QVERIFY(standIn->listen());
+        standIn->setSerialNumber(QString::number(28096312 + i));
+        m_standIns.append(standIn);
+
+        BeoDevice *device = new BeoDevice(standIn->address(), QString("media_player.soak_%1").arg(i), m_manager,
+                                          m_artwork, nullptr, lcSoak(), this);
+        // an entity that supports every feature, so the shadow, optimistic state and playback clock all run
+        m_entities.append(QHash<int, QVariant>());
+        device->attachEntity([](int) { return true; }, [this, i](int attribute, const QVariant &value) {
+            m_entities[i].insert(attribute, value);
+            m_entityUpdates++;
+        });
+        device->setStreamIdleTimeout(STREAM_IDLE_TIMEOUT);
+        device->setProgressInterval(100);
+        device->connectToDevice();
+        m_devices.append(device);
+    }
+    settle();
+}
+
+void TestSoak::cleanupTestCase() {
+    qtHookData[QHooks::AddQObject] = g_previousAddHook;
+    qtHookData[QHooks::RemoveQObject] = g_previousRemoveHook;
+}
+
+void TestSoak::soak() {
+    const int iterations = environment("SOAK_ITERATIONS", 2000);
+    const int warmUp = environment("SOAK_WARMUP", qMin(200, iterations / 4));
+
+    for (int i = 0; i < warmUp; i++) {
+        step(i);
+    }
+    settle();
+    const Usage baseline = Usage::measure(m_manager);
+    qInfo("Baseline after %d steps: %lld kB resident, %d objects, %d replies", warmUp, baseline.rssKb,
+          baseline.objects, baseline.replies);
+
+    for (int i = warmUp; i < iterations; i++) {
+        step(i);
+        if ((i - warmUp + 1) % 500 == 0) {
+            Usage usage = Usage::measure(m_manager);
+            qInfo("Step %d: %lld kB resident, %d objects, %d replies", i + 1, usage.rssKb, usage.objects,
+                  usage.replies);
+        }
+    }
+    settle();
+    const Usage usage = Usage::measure(m_manager);
+    qInfo("After %d steps: %lld kB resident, %d objects, %d replies", iterations, usage.rssKb, usage.objects,
+          usage.replies);
+
+    QVERIFY(m_entityUpdates > 0);
+    QVERIFY2(usage.replies <= baseline.replies,
+             qPrintable(QString("network replies grew from %1 to %2").arg(baseline.replies).arg(usage.replies)));
+    QVERIFY2(usage.objects <= baseline.objects + OBJECT_SLACK,
+             qPrintable(QString("live QObjects grew from %1 to %2").arg(baseline.objects).arg(usage.objects)));
+    if (baseline.rssKb >= 0) {
+        QVERIFY2(usage.rssKb <= baseline.rssKb + RSS_SLACK_KB,
+                 qPrintable(QString("resident memory grew from %1 kB to %2 kB").arg(baseline.rssKb).arg(usage.rssKb)));
+    }
+}
+
+void TestSoak::step(int index) {
+    static const int COMMANDS[] = {MediaPlayerDef::C_PLAY,       MediaPlayerDef::C_PAUSE,
+                                   MediaPlayerDef::C_NEXT,       MediaPlayerDef::C_PREVIOUS,
+                                   MediaPlayerDef::C_VOLUME_SET, MediaPlayerDef::C_VOLUME_UP,
+                                   MediaPlayerDef::C_MUTE,       MediaPlayerDef::C_TURNON};
+
+    int         device = m_random.bounded(m_devices.size());
+    BeoDevice  *beoDevice = m_devices.at(device);
+    BeoStandIn *standIn = m_standIns.at(device);
+
+    switch (m_random.bounded(16)) {
+        case 0:
+        case 1:
+        case 2:
+        case 3: {
+            int command = COMMANDS[m_random.bounded(static_cast<int>(sizeof(COMMANDS) / sizeof(COMMANDS[0])))];
+            beoDevice->sendCommand(command, m_random.bounded(90));
+            break;
+        }
+        case 4:
+            if (!standIn->isReplaying()) {
+                standIn->replay(m_trace, 0);
+            }
+            break;
+        case 5:
+            beoDevice->getSources([](bool, const QVariantList &) {});
+            break;
+        case 6:
+            standIn->dropConnections();
+            break;
+        case 7:
+            // unplugged for a moment, the reconnect backoff takes over
+            standIn->setOffline(true);
+            QTimer::singleShot(static_cast<int>(m_random.bounded(50, 300)), standIn,
+                               [standIn]() { standIn->setOffline(false); });
+            break;
+        case 8:
+            // standby of the remote and wake up
+            beoDevice->disconnectFromDevice();
+            m_artwork->cancelAll();
+            beoDevice->connectToDevice();
+            break;
+        case 9:
+            standIn->setResponseDelay(static_cast<int>(m_random.bounded(0, 200)));
+            break;
+        case 10:
+            standIn->setErrorStatus("/BeoZone/Zone/Stream", m_random.bounded(2) ? 500 : 0);
+            break;
+        case 11:
+            standIn->setSplitSize(static_cast<int>(m_random.bounded(0, 64)));
+            break;
+        case 12:
+            // the shared polling timer of the integration
+            beoDevice->poll();
+            break;
+        case 13:
+            // a quiet stream, the idle watchdog asks for the standby state
+            standIn->stallStreams(static_cast<int>(m_random.bounded(STREAM_IDLE_TIMEOUT, 3 * STREAM_IDLE_TIMEOUT)));
+            break;
+        case 14:
+            // a product that lost power keeps the connections open without answering
+            standIn->setUnresponsive(true);
+            QTimer::singleShot(static_cast<int>(m_random.bounded(STREAM_IDLE_TIMEOUT, 3 * STREAM_IDLE_TIMEOUT)),
+                               standIn, [standIn]() { standIn->setUnresponsive(false); });
+            break;
+        case 15:
+            beoDevice->sendCommand(m_random.bounded(2) ? MediaPlayerDef::C_TURNOFF : MediaPlayerDef::C_TURNON,
+                                   QVariant());
+            break;
+    }
+
+    // requests are recorded by the stand-in, they are not part of the measurement
+    standIn->clearRequests();
+    if (index % 50 == 0) {
+        // a stuck product recovers through the backoff, this keeps the run short
+        for (BeoDevice *each : m_devices) {
+            each->reconnectNow();
+        }
+    }
+    QTest::qWait(static_cast<int>(m_random.bounded(5, 30)));
+}
+
+void TestSoak::settle() {
+    // back to a healthy network with every product connected and nothing in flight
+    for (BeoStandIn *standIn : m_standIns) {
+        standIn->stopReplay();
+        standIn->setOffline(false);
+        standIn->setUnresponsive(false);
+        standIn->stallStreams(0);
+        standIn->setResponseDelay(0);
+        standIn->setErrorStatus("/BeoZone/Zone/Stream", 0);
+        standIn->setSplitSize(0);
+        standIn->clearRequests();
+    }
+    for (BeoDevice *device : m_devices) {
+        if (device->connectionState() == BeoDevice::DISCONNECTED) {
+            device->connectToDevice();
+        }
+        device->reconnectNow();
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(std::all_of(m_devices.cbegin(), m_devices.cend(),
+                                         [](BeoDevice *device) { return device->isConnected(); }),
+                             15000);
+    QTRY_VERIFY_WITH_TIMEOUT(std::all_of(m_devices.cbegin(), m_devices.cend(),
+                                         [](BeoDevice *device) {
+                                             QVariantMap metrics = device->metrics();
+                                             return metrics.value("in_flight").toInt() == 0 &&
+                                                    metrics.value("queued").toInt() == 0;
+                                         }),
+                             15000);
+    // deleteLater of the finished replies and closed sockets
+    QTest::qWait(500);
+}
+
+QTEST_GUILESS_MAIN(TestSoak)
+#include "tst_soak.moc"
@@ -0,0 +1,538 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "beostandin.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+
+// frames sent per event loop turn while replaying, the client gets a chance to read in between
+static const int REPLAY_BATCH = 64;
+
+static const char STREAM_PATH_PREFIX[] = "/BeoZone/Zone/Stream/";
+
+static QByteArray reasonPhrase(int status) {
+    switch (status) {
+        case 200:
+            return "OK";
+        case 304:
+            return "Not Modified";
+        case 400:
+            return "Bad Request";
+        case 404:
+            return "Not Found";
+        case 500:
+            return "Internal Server Error";
+        case 503:
+            return "Service Unavailable";
+        default:
+            return "Error";
+    }
+}
+
+static void writeChunk(QTcpSocket *socket, const QByteArray &data) {
+    socket->write(QByteArray::number(data.size(), 16) + "\r\n" + data + "\r\n");
+}
+
+BeoStandIn::BeoStandIn(QObject *parent) : QObject(parent) {
+    m_clock.start();
+
+    m_server = new QTcpServer(this);
+    QObject::connect(m_server, &QTcpServer::newConnection, this, &BeoStandIn::onNewConnection);
+
+    m_writeTimer = new QTimer(this);
+    m_writeTimer->setSingleShot(true);
+    QObject::connect(m_writeTimer, &QTimer::timeout, this, &BeoStandIn::onWriteTimer);
+
+    m_replayTimer = new QTimer(this);
+    m_replayTimer->setSingleShot(true);
+    QObject::connect(m_replayTimer, &QTimer::timeout, this, &BeoStandIn::onReplayTimer);
+}
+
+BeoStandIn::~BeoStandIn() { dropConnections(); }
+
+bool BeoStandIn::listen(quint16 port) {
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        return false;
+    }
+    m_port = m_server->serverPort();
+    return true;
+}
+
+void BeoStandIn::sendFrame(const QByteArray &frame) {
+    QByteArray data = frame + "\r\n\r\n";
+    if (m_splitSize > 0) {
+        for (int i = 0; i < data.size(); i += m_splitSize) {
+            m_outgoing.append(data.mid(i, m_splitSize));
+        }
+    } else {
+        m_outgoing.append(data);
+    }
+    scheduleWrite();
+}
+
+void BeoStandIn::replay(const QList<TraceEntry> &trace, double speed) {
+    m_trace = trace;
+    m_traceIndex = 0;
+    m_traceSpeed = speed;
+    m_traceClock.start();
+    m_replayTimer->start(0);
+}
+
+void BeoStandIn::stopReplay() {
+    m_replayTimer->stop();
+    m_trace.clear();
+}
+
+void BeoStandIn::stallStreams(int msecs) {
+    m_stalledUntil = m_clock.elapsed() + msecs;
+    if (m_writeTimer->isActive()) {
+        m_writeTimer->start(msecs);
+    }
+}
+
+void BeoStandIn::dropConnections() {
+    const QList<QTcpSocket *> sockets = m_sockets;
+    for (QTcpSocket *socket : sockets) {
+        socket->abort();
+        onDisconnected(socket);
+    }
+    m_outgoing.clear();
+}
+
+void BeoStandIn::setUnresponsive(bool unresponsive) {
+    m_unresponsive = unresponsive;
+    if (unresponsive) {
+        m_outgoing.clear();
+    }
+}
+
+void BeoStandIn::setOffline(bool offline) {
+    if (offline) {
+        m_server->close();
+        dropConnections();
+    } else if (!m_server->isListening()) {
+        m_server->listen(QHostAddress::LocalHost, m_port);
+    }
+}
+
+void BeoStandIn::setErrorStatus(const QString &pathPrefix, int status) {
+    if (status > 0) {
+        m_errors.insert(pathPrefix, status);
+    } else {
+        m_errors.remove(pathPrefix);
+    }
+}
+
+int BeoStandIn::requestCount(const QString &path) const {
+    int count = 0;
+    for (const Request &request : m_requests) {
+        if (request.path.section('?', 0, 0) == path) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void BeoStandIn::onNewConnection() {
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket *socket = m_server->nextPendingConnection();
+        m_sockets.append(socket);
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [=]() { onReadyRead(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [=]() { onDisconnected(socket); });
+    }
+}
+
+void BeoStandIn::onReadyRead(QTcpSocket *socket) {
+    if (!m_sockets.contains(socket)) {
+        return;
+    }
+    QByteArray data = socket->readAll();
+    // a gone product reads nothing, a stream does not take requests
+    if (m_unresponsive || m_streams.contains(socket)) {
+        return;
+    }
+
+    m_buffers[socket].append(data);
+    while (m_buffers.contains(socket) && !m_streams.contains(socket)) {
+        QByteArray &buffer = m_buffers[socket];
+        int         headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        Request                 request;
+        if (requestLine.size() >= 2) {
+            request.method = requestLine.at(0);
+            request.path = QString::fromUtf8(requestLine.at(1));
+        }
+        for (int i = 1; i < lines.size(); i++) {
+            const QByteArray &line = lines.at(i);
+            int               colon = line.indexOf(':');
+            if (colon > 0) {
+                request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+            }
+        }
+
+        int length = request.headers.value("content-length").toInt();
+        int total = headerEnd + 4 + length;
+        if (buffer.size() < total) {
+            return;
+        }
+        request.body = buffer.mid(headerEnd + 4, length);
+        buffer.remove(0, total);
+
+        if (request.method.isEmpty()) {
+            respond(socket, 400, QJsonObject());
+        } else {
+            handleRequest(socket, request);
+        }
+    }
+}
+
+void BeoStandIn::onDisconnected(QTcpSocket *socket) {
+    if (!m_sockets.removeOne(socket)) {
+        return;
+    }
+    m_streams.removeOne(socket);
+    m_buffers.remove(socket);
+    socket->deleteLater();
+}
+
+void BeoStandIn::handleRequest(QTcpSocket *socket, const Request &request) {
+    m_requests.append(request);
+    emit requestReceived(request.method, request.path);
+
+    const QString     path = request.path.section('?', 0, 0);
+    const QByteArray &method = request.method;
+
+    for (auto iter = m_errors.cbegin(); iter != m_errors.cend(); ++iter) {
+        if (path.startsWith(iter.key())) {
+            QJsonObject error;
+            error.insert("message", "Injected error");
+            QJsonObject answer;
+            answer.insert("error", error);
+            respond(socket, iter.value(), answer);
+            return;
+        }
+    }
+
+    if (method == "GET" && path == "/BeoNotify/Notifications") {
+        openStream(socket);
+        return;
+    }
+
+    const QJsonObject body = QJsonDocument::fromJson(request.body).object();
+    QJsonObject       answer;
+
+    if (method == "GET" && path == "/BeoDevice") {
+        respond(socket, 200, deviceInfo());
+    } else if (path == "/BeoDevice/powerManagement/standby") {
+        if (method == "PUT") {
+            bool on = body.value("standby").toObject().value("powerState").toString() == "on";
+            respond(socket, 200, answer);
+            if (on != m_on) {
+                m_on = on;
+                if (!on) {
+                    m_playState = "stop";
+                }
+                sendFrame(NotificationTrace::standbyFrame(on));
+            }
+        } else {
+            QJsonObject standby;
+            standby.insert("powerState", m_on ? "on" : "standby");
+            answer.insert("standby", standby);
+            respond(socket, 200, answer);
+        }
+    } else if (method == "GET" && path == "/BeoZone/Zone") {
+        QJsonObject zone;
+        zone.insert("sound", QJsonObject());
+        zone.insert("stream", QJsonObject());
+        zone.insert("sources", QJsonObject());
+        answer.insert("zone", zone);
+        respond(socket, 200, answer);
+    } else if (method == "GET" && path == "/BeoZone/Zone/Sound/Volume") {
+        QJsonObject speaker;
+        speaker.insert("level", m_volume);
+        speaker.insert("muted", m_muted);
+        QJsonObject volume;
+        volume.insert("speaker", speaker);
+        answer.insert("volume", volume);
+        respond(socket, 200, answer);
+    } else if (method == "PUT" && path == "/BeoZone/Zone/Sound/Volume/Speaker/Level") {
+        m_volume = qBound(0, body.value("level").toInt(m_volume), 90);
+        respond(socket, 200, answer);
+        sendFrame(NotificationTrace::volumeFrame(m_volume, m_muted));
+    } else if (method == "PUT" && path == "/BeoZone/Zone/Sound/Volume/Speaker/Muted") {
+        m_muted = body.value("muted").toBool();
+        respond(socket, 200, answer);
+        sendFrame(NotificationTrace::volumeFrame(m_volume, m_muted));
+    } else if (method == "POST" && path.startsWith(STREAM_PATH_PREFIX)) {
+        QString button = path.mid(static_cast<int>(qstrlen(STREAM_PATH_PREFIX)));
+        respond(socket, 200, answer);
+        if (!button.endsWith("/Release")) {
+            pressButton(button);
+        }
+    } else if (path == "/BeoZone/Zone/ActiveSources" && method == "POST") {
+        QString id = body.value("primaryExperience").toObject().value("source").toObject().value("id").toString();
+        respond(socket, 200, answer);
+        if (!id.isEmpty()) {
+            m_sourceId = id;
+            m_on = true;
+            sendFrame(sourceFrame());
+        }
+    } else if (path == "/BeoZone/Zone/ActiveSources" && method == "GET") {
+        QJsonObject activeSources;
+        activeSources.insert("primaryExperience", primaryExperience());
+        answer.insert("activeSources", activeSources);
+        respond(socket, 200, answer);
+    } else if (method == "DELETE" && path == "/BeoZone/Zone/ActiveSources/primaryExperience") {
+        m_sourceId.clear();
+        respond(socket, 200, answer);
+        sendFrame(sourceFrame());
+    } else if (method == "POST" && path == "/BeoZone/Zone/Device/OneWayJoin") {
+        respond(socket, 200, answer);
+    } else if (method == "GET" && path == "/BeoZone/Zone/Sources") {
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray                    etag = QString("\"sources-%1\"").arg(m_sourcesRevision).toUtf8();
+        headers.insert("ETag", etag);
+        if (request.headers.value("if-none-match") == etag) {
+            respond(socket, 304, answer, headers);
+        } else {
+            respond(socket, 200, sources(), headers);
+        }
+    } else {
+        QJsonObject error;
+        error.insert("message", "Unknown resource " + path);
+        answer.insert("error", error);
+        respond(socket, 404, answer);
+    }
+}
+
+void BeoStandIn::openStream(QTcpSocket *socket) {
+    m_streams.append(socket);
+    socket->write(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n");
+
+    // the product starts the stream with its current state
+    QByteArray initial;
+    if (m_on) {
+        initial.append(NotificationTrace::volumeFrame(m_volume, m_muted) + "\r\n\r\n");
+        initial.append(sourceFrame() + "\r\n\r\n");
+        initial.append(progressFrame() + "\r\n\r\n");
+    } else {
+        initial.append(NotificationTrace::standbyFrame(false) + "\r\n\r\n");
+    }
+    writeChunk(socket, initial);
+    emit streamOpened();
+}
+
+void BeoStandIn::respond(QTcpSocket *socket, int status, const QJsonObject &body,
+                         const QHash<QByteArray, QByteArray> &headers) {
+    QByteArray data = status == 304 ? QByteArray() : QJsonDocument(body).toJson(QJsonDocument::Compact);
+    if (m_responseDelay > 0) {
+        // the socket is the context, a dropped connection is not answered
+        QTimer::singleShot(m_responseDelay, socket, [=]() { writeResponse(socket, status, data, headers); });
+    } else {
+        writeResponse(socket, status, data, headers);
+    }
+}
+
+void BeoStandIn::writeResponse(QTcpSocket *socket, int status, const QByteArray &body,
+                               const QHash<QByteArray, QByteArray> &headers) {
+    if (m_unresponsive || !m_sockets.contains(socket)) {
+        return;
+    }
+
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+    response.append("Content-Type: application/json\r\n");
+    response.append("Content-Length: " + QByteArray::number(body.size()) + "\r\n");
+    response.append("Connection: keep-alive\r\n");
+    for (auto iter = headers.cbegin(); iter != headers.cend(); ++iter) {
+        response.append(iter.key() + ": " + iter.value() + "\r\n");
+    }
+    response.append("\r\n");
+    response.append(body);
+    socket->write(response);
+}
+
+void BeoStandIn::scheduleWrite() {
+    if (!m_writeTimer->isActive()) {
+        m_writeTimer->start(static_cast<int>(qMax<qint64>(0, m_stalledUntil - m_clock.elapsed())));
+    }
+}
+
+void BeoStandIn::onWriteTimer() {
+    if (m_unresponsive || m_outgoing.isEmpty()) {
+        m_outgoing.clear();
+        return;
+    }
+    qint64 now = m_clock.elapsed();
+    if (now < m_stalledUntil) {
+        m_writeTimer->start(static_cast<int>(m_stalledUntil - now));
+        return;
+    }
+
+    // whole frames go out together, split pieces one per turn so they arrive in separate reads
+    QByteArray data;
+    if (m_splitSize > 0) {
+        data = m_outgoing.takeFirst();
+    } else {
+        for (const QByteArray &piece : m_outgoing) {
+            data.append(piece);
+        }
+        m_outgoing.clear();
+    }
+    for (QTcpSocket *socket : m_streams) {
+        writeChunk(socket, data);
+    }
+
+    if (!m_outgoing.isEmpty()) {
+        m_writeTimer->start(m_splitSize > 0 ? 1 : 0);
+    }
+}
+
+void BeoStandIn::onReplayTimer() {
+    qint64 elapsed = m_traceClock.elapsed();
+    int    sent = 0;
+    while (m_traceIndex < m_trace.size() && sent < REPLAY_BATCH) {
+        const TraceEntry &entry = m_trace.at(m_traceIndex);
+        qint64            due = m_traceSpeed > 0 ? static_cast<qint64>(entry.offset / m_traceSpeed) : 0;
+        if (due > elapsed) {
+            m_replayTimer->start(static_cast<int>(due - elapsed));
+            return;
+        }
+        sendFrame(entry.frame);
+        m_traceIndex++;
+        sent++;
+    }
+
+    if (m_traceIndex < m_trace.size()) {
+        m_replayTimer->start(0);
+        return;
+    }
+    m_trace.clear();
+    emit replayFinished();
+}
+
+void BeoStandIn::pressButton(const QString &button) {
+    if (button == "Play") {
+        m_on = true;
+        m_playState = "play";
+    } else if (button == "Pause") {
+        m_playState = "pause";
+    } else if (button == "Stop") {
+        m_playState = "stop";
+    } else if (button == "Forward" || button == "Backward") {
+        m_track = qMax(0, m_track + (button == "Forward" ? 1 : -1));
+        sendFrame(trackFrame());
+    } else {
+        return;
+    }
+    sendFrame(progressFrame());
+}
+
+QJsonObject BeoStandIn::deviceInfo() const {
+    QJsonObject productId;
+    productId.insert("productType", "BeoSound Core");
+    productId.insert("typeNumber", "2714");
+    productId.insert("itemNumber", "1200306");
+    productId.insert("serialNumber", m_serialNumber);
+
+    QJsonObject friendlyName;
+    friendlyName.insert("productFriendlyName", "Stand-in");
+
+    QJsonObject software;
+    software.insert("version", m_firmware);
+
+    QJsonObject device;
+    device.insert("productId", productId);
+    device.insert("productFriendlyName", friendlyName);
+    device.insert("software", software);
+
+    QJsonObject object;
+    object.insert("beoDevice", device);
+    return object;
+}
+
+QJsonObject BeoStandIn::primaryExperience() const {
+    if (m_sourceId.isEmpty() || !m_on) {
+        return QJsonObject();
+    }
+    QString jid = QString("2714.1200306.%1@products.bang-olufsen.com").arg(m_serialNumber);
+
+    QJsonObject product;
+    product.insert("jid", jid);
+    product.insert("friendlyName", "Stand-in");
+
+    QJsonObject source;
+    source.insert("id", m_sourceId);
+    source.insert("friendlyName", m_sourceId.section(':', 0, 0));
+    source.insert("product", product);
+
+    QJsonObject experience;
+    experience.insert("source", source);
+    experience.insert("listener", QJsonArray{jid});
+    return experience;
+}
+
+QJsonObject BeoStandIn::sources() const {
+    static const char *const IDS[] = {"deezer:2714.1200306.28096312@products.bang-olufsen.com",
+                                      "radio:2714.1200306.28096312@products.bang-olufsen.com",
+                                      "linein:2714.1200306.28096312@products.bang-olufsen.com"};
+    static const char *const CATEGORIES[] = {"MUSIC", "RADIO", "MUSIC"};
+
+    QJsonArray list;
+    for (int i = 0; i < 3; i++) {
+        QString     id = IDS[i];
+        QJsonObject source;
+        source.insert("id", id);
+        source.insert("friendlyName", id.section(':', 0, 0));
+        source.insert("category", CATEGORIES[i]);
+        source.insert("inUse", id == m_sourceId);
+        list.append(QJsonArray{id, source});
+    }
+
+    QJsonObject object;
+    object.insert("sources", list);
+    return object;
+}
+
+QByteArray BeoStandIn::sourceFrame() const {
+    QJsonObject data;
+    data.insert("primaryExperience", primaryExperience());
+    return NotificationTrace::frame("SOURCE", data);
+}
+
+QByteArray BeoStandIn::progressFrame() const { return NotificationTrace::progressFrame(m_playState, 0, 240); }
+
+QByteArray BeoStandIn::trackFrame() const {
+    return NotificationTrace::storedMusicFrame(QString("Track %1").arg(m_track + 1), "Stand-in Artist",
+                                               "Stand-in Album",
+                                               QString("http://127.0.0.1:%1/art/%2.jpg").arg(m_port).arg(m_track));
+}
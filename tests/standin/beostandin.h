@@ -0,0 +1,183 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "notificationtrace.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// BANG&OLUFSEN STAND-IN
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Local stand-in for a Bang & Olufsen product, an HTTP/1.1 server on the loopback interface.
+/// Serves the chunked /BeoNotify/Notifications stream, the /BeoZone/Zone command and state endpoints, /BeoDevice and
+/// /BeoDevice/powerManagement/standby. Commands change the state of the stand-in and are reported on the stream like
+/// the product does. Recorded traces are replayed at real or accelerated speed.
+/// Faults are injected on request: frames split over several reads, stalled streams, dropped connections, a product
+/// that is gone without closing its connections, refused connections, slow answers and HTTP errors.
+class BeoStandIn : public QObject {
+    Q_OBJECT
+
+ public:
+    struct Request {
+        QByteArray                    method;
+        QString                       path;
+        QHash<QByteArray, QByteArray> headers;  // lower case names
+        QByteArray                    body;
+    };
+
+    explicit BeoStandIn(QObject* parent = nullptr);
+    ~BeoStandIn() override;
+
+    /// Listens on the loopback interface, on a free port if port is 0.
+    bool    listen(quint16 port = 0);
+    quint16 port() const { return m_port; }
+
+    /// Address in the form the integration takes it, host and port.
+    QString address() const { return QString("127.0.0.1:%1").arg(m_port); }
+
+    // state of the product, the setters do not notify the streams
+    QString serialNumber() const { return m_serialNumber; }
+    void    setSerialNumber(const QString& serialNumber) { m_serialNumber = serialNumber; }
+    QString firmware() const { return m_firmware; }
+    void    setFirmware(const QString& firmware) { m_firmware = firmware; }
+    bool    isOn() const { return m_on; }
+    void    setOn(bool on) { m_on = on; }
+    int     volume() const { return m_volume; }
+    void    setVolume(int volume) { m_volume = volume; }
+    bool    isMuted() const { return m_muted; }
+    QString playState() const { return m_playState; }
+
+    // notification stream
+    int  streamCount() const { return m_streams.size(); }
+    void sendFrame(const QByteArray& frame);
+
+    /// Replays a trace. speed 1 keeps the recorded timing, 10 is ten times faster, 0 sends the frames as fast as
+    /// the event loop allows.
+    void replay(const QList<TraceEntry>& trace, double speed = 1.0);
+    void stopReplay();
+    bool isReplaying() const { return m_replayTimer->isActive(); }
+
+    // faults
+
+    /// Every frame is written in pieces of size bytes, one piece per event loop turn. 0 writes whole frames.
+    void setSplitSize(int size) { m_splitSize = size; }
+
+    /// Holds back the stream data for msecs, then sends everything at once.
+    void stallStreams(int msecs);
+
+    /// Resets all client connections, the stream and requests in flight fail.
+    void dropConnections();
+
+    /// The product is gone without closing its connections: nothing is answered or sent any more.
+    void setUnresponsive(bool unresponsive);
+
+    /// Stops listening and drops the connections, like an unplugged product. New connections are refused.
+    void setOffline(bool offline);
+
+    /// Delays the answers of the REST requests.
+    void setResponseDelay(int msecs) { m_responseDelay = msecs; }
+
+    /// Answers the requests to paths starting with pathPrefix with status. 0 removes the error.
+    void setErrorStatus(const QString& pathPrefix, int status);
+
+    // requests received, streams included
+    const QList<Request>& requests() const { return m_requests; }
+    int                   requestCount(const QString& path) const;
+    void                  clearRequests() { m_requests.clear(); }
+
+    int connectionCount() const { return m_sockets.size(); }
+
+ signals:
+    void requestReceived(const QByteArray& method, const QString& path);
+    void streamOpened();
+    void replayFinished();
+
+ private:
+    void onNewConnection();
+    void onReadyRead(QTcpSocket* socket);
+    void onDisconnected(QTcpSocket* socket);
+    void handleRequest(QTcpSocket* socket, const Request& request);
+    void openStream(QTcpSocket* socket);
+    void respond(QTcpSocket* socket, int status, const QJsonObject& body,
+                 const QHash<QByteArray, QByteArray>& headers = QHash<QByteArray, QByteArray>());
+    void writeResponse(QTcpSocket* socket, int status, const QByteArray& body,
+                       const QHash<QByteArray, QByteArray>& headers);
+    void scheduleWrite();
+    void onWriteTimer();
+    void onReplayTimer();
+    void pressButton(const QString& button);
+
+    QJsonObject deviceInfo() const;
+    QJsonObject primaryExperience() const;
+    QJsonObject sources() const;
+    QByteArray  sourceFrame() const;
+    QByteArray  progressFrame() const;
+    QByteArray  trackFrame() const;
+
+    QTcpServer*                    m_server;
+    quint16                        m_port = 0;
+    QList<QTcpSocket*>             m_sockets;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+    QList<QTcpSocket*>             m_streams;
+    QList<Request>                 m_requests;
+    QHash<QString, int>            m_errors;
+    QElapsedTimer                  m_clock;
+
+    // stream output, written by the timer so split pieces arrive in separate reads
+    QList<QByteArray> m_outgoing;
+    QTimer*           m_writeTimer;
+    int               m_splitSize = 0;
+    qint64            m_stalledUntil = 0;
+    bool              m_unresponsive = false;
+    int               m_responseDelay = 0;
+
+    // trace replay
+    QList<TraceEntry> m_trace;
+    int               m_traceIndex = 0;
+    double            m_traceSpeed = 1.0;
+    QElapsedTimer     m_traceClock;
+    QTimer*           m_replayTimer;
+
+    // product state
+    QString m_serialNumber = "28096312";
+    QString m_firmware = "1.18.34.1211";
+    bool    m_on = true;
+    int     m_volume = 30;
+    bool    m_muted = false;
+    QString m_playState = "stop";
+    int     m_track = 0;
+    QString m_sourceId = "deezer:2714.1200306.28096312@products.bang-olufsen.com";
+    int     m_sourcesRevision = 1;
+};
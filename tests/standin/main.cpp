@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTimer>
+#include <QtDebug>
+
+#include "beostandin.h"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("beo-standin");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for a Bang & Olufsen product");
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "Port to listen on.", "port", "8080");
+    QCommandLineOption traceOption("trace", "Notification trace to replay.", "file");
+    QCommandLineOption speedOption("speed", "Replay speed, 1 is real time, 0 as fast as possible.", "factor", "1");
+    QCommandLineOption loopOption("loop", "Replay the trace again when it finished.");
+    QCommandLineOption splitOption("split", "Write the frames in pieces of this size.", "bytes", "0");
+    QCommandLineOption serialOption("serial", "Serial number of the product.", "serial");
+    QCommandLineOption dropOption("drop-every", "Drop all connections every n seconds.", "seconds", "0");
+    QCommandLineOption stallOption("stall-every", "Stall the notification stream for 5 s every n seconds.", "seconds",
+                                   "0");
+    parser.addOptions(
+        {portOption, traceOption, speedOption, loopOption, splitOption, serialOption, dropOption, stallOption});
+    parser.process(app);
+
+    BeoStandIn standIn;
+    if (parser.isSet(serialOption)) {
+        standIn.setSerialNumber(parser.value(serialOption));
+    }
+    standIn.setSplitSize(parser.value(splitOption).toInt());
+    if (!standIn.listen(static_cast<quint16>(parser.value(portOption).toUInt()))) {
+        qCritical() << "Cannot listen on port" << parser.value(portOption);
+        return 1;
+    }
+    qInfo() << "Bang & Olufsen stand-in listening on" << standIn.address();
+
+    QObject::connect(&standIn, &BeoStandIn::requestReceived, [](const QByteArray &method, const QString &path) {
+        qInfo().noquote() << method << path;
+    });
+
+    if (parser.isSet(traceOption)) {
+        QList<TraceEntry> trace;
+        QString           errorString;
+        if (!NotificationTrace::load(parser.value(traceOption), &trace, &errorString)) {
+            qCritical() << "Cannot load the trace" << parser.value(traceOption) << errorString;
+            return 1;
+        }
+        double speed = parser.value(speedOption).toDouble();
+        bool   loop = parser.isSet(loopOption);
+        QObject::connect(&standIn, &BeoStandIn::replayFinished, [&standIn, trace, speed, loop]() {
+            qInfo() << "Trace replayed";
+            if (loop) {
+                standIn.replay(trace, speed);
+            }
+        });
+        standIn.replay(trace, speed);
+    }
+
+    int dropEvery = parser.value(dropOption).toInt();
+    if (dropEvery > 0) {
+        QTimer *timer = new QTimer(&standIn);
+        QObject::connect(timer, &QTimer::timeout, [&standIn]() {
+            qInfo() << "Dropping all connections";
+            standIn.dropConnections();
+        });
+        timer->start(dropEvery * 1000);
+    }
+
+    int stallEvery = parser.value(stallOption).toInt();
+    if (stallEvery > 0) {
+        QTimer *timer = new QTimer(&standIn);
+        QObject::connect(timer, &QTimer::timeout, [&standIn]() {
+            qInfo() << "Stalling the notification stream";
+            standIn.stallStreams(5000);
+        });
+        timer->start(stallEvery * 1000);
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,163 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "notificationtrace.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+bool NotificationTrace::load(const QString &fileName, QList<TraceEntry> *entries, QString *errorString) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    return parse(file.readAll(), entries, errorString);
+}
+
+bool NotificationTrace::parse(const QByteArray &data, QList<TraceEntry> *entries, QString *errorString) {
+    entries->clear();
+    const QList<QByteArray> lines = data.split('\n');
+    for (int i = 0; i < lines.size(); i++) {
+        QByteArray line = lines.at(i).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        int        separator = line.indexOf(' ');
+        bool       ok = false;
+        TraceEntry entry;
+        entry.offset = separator > 0 ? line.left(separator).toLongLong(&ok) : 0;
+        entry.frame = line.mid(separator + 1).trimmed();
+        if (!ok || entry.offset < 0 || entry.frame.isEmpty()) {
+            if (errorString) {
+                *errorString = QString("Invalid trace entry in line %1").arg(i + 1);
+            }
+            return false;
+        }
+        entries->append(entry);
+    }
+    return true;
+}
+
+QString NotificationTrace::typeOf(const QByteArray &frame) {
+    return QJsonDocument::fromJson(frame).object().value("notification").toObject().value("type").toString();
+}
+
+QByteArray NotificationTrace::frame(const QString &type, const QJsonObject &data) {
+    static int id = 0;
+
+    QJsonObject notification;
+    notification.insert("id", ++id);
+    notification.insert("timestamp", "2020-05-01T12:00:00.000000");
+    notification.insert("type", type);
+    notification.insert("kind", "playing");
+    notification.insert("data", data);
+
+    QJsonObject object;
+    object.insert("notification", notification);
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+QByteArray NotificationTrace::volumeFrame(int level, bool muted) {
+    QJsonObject range;
+    range.insert("minimum", 0);
+    range.insert("maximum", 90);
+
+    QJsonObject speaker;
+    speaker.insert("level", level);
+    speaker.insert("muted", muted);
+    speaker.insert("range", range);
+
+    QJsonObject data;
+    data.insert("speaker", speaker);
+    return frame("VOLUME", data);
+}
+
+QByteArray NotificationTrace::progressFrame(const QString &state, int position, int duration) {
+    QJsonObject data;
+    data.insert("state", state);
+    data.insert("position", position);
+    data.insert("totalDuration", duration);
+    data.insert("seekSupported", false);
+    data.insert("playQueueItemId", "plid-1");
+    return frame("PROGRESS_INFORMATION", data);
+}
+
+QByteArray NotificationTrace::sourceFrame(const QString &id, const QString &friendlyName, const QString &productJid,
+                                          const QString &productName) {
+    QJsonObject product;
+    product.insert("jid", productJid);
+    product.insert("friendlyName", productName);
+
+    QJsonObject source;
+    source.insert("id", id);
+    source.insert("friendlyName", friendlyName);
+    source.insert("product", product);
+
+    QJsonObject primaryExperience;
+    primaryExperience.insert("source", source);
+    primaryExperience.insert("listener", QJsonArray{productJid});
+
+    QJsonObject data;
+    data.insert("primaryExperience", primaryExperience);
+    return frame("SOURCE", data);
+}
+
+QByteArray NotificationTrace::storedMusicFrame(const QString &title, const QString &artist, const QString &album,
+                                               const QString &imageUrl) {
+    QJsonObject image;
+    image.insert("url", imageUrl);
+    image.insert("size", "large");
+    image.insert("mediatype", "image/jpg");
+
+    QJsonObject data;
+    data.insert("name", title);
+    data.insert("artist", artist);
+    data.insert("album", album);
+    data.insert("trackImage", QJsonArray{image});
+    return frame("NOW_PLAYING_STORED_MUSIC", data);
+}
+
+QByteArray NotificationTrace::netRadioFrame(const QString &name, const QString &liveDescription,
+                                            const QString &imageUrl) {
+    QJsonObject image;
+    image.insert("url", imageUrl);
+    image.insert("size", "large");
+
+    QJsonObject data;
+    data.insert("name", name);
+    data.insert("liveDescription", liveDescription);
+    data.insert("image", QJsonArray{image});
+    return frame("NOW_PLAYING_NET_RADIO", data);
+}
+
+QByteArray NotificationTrace::standbyFrame(bool on) {
+    QJsonObject data;
+    data.insert("powerState", on ? "on" : "standby");
+    return frame("STANDBY", data);
+}
+
+QByteArray NotificationTrace::shutdownFrame() { return frame("SHUTDOWN", QJsonObject()); }
@@ -0,0 +1,62 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// NOTIFICATION TRACE
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// One recorded notification, offset is the time in ms since the start of the recording.
+struct TraceEntry {
+    qint64     offset = 0;
+    QByteArray frame;
+};
+
+/// Recorded /BeoNotify/Notifications traffic and the notification frames of a product.
+/// A trace file has one frame per line: the offset in ms, a space and the JSON frame. Empty lines and lines starting
+/// with # are skipped, so a recording can be annotated.
+class NotificationTrace {
+ public:
+    static bool load(const QString& fileName, QList<TraceEntry>* entries, QString* errorString = nullptr);
+    static bool parse(const QByteArray& data, QList<TraceEntry>* entries, QString* errorString = nullptr);
+
+    /// Type of the notification of a frame, empty if it is not a notification.
+    static QString typeOf(const QByteArray& frame);
+
+    // frames as sent by the product
+    static QByteArray frame(const QString& type, const QJsonObject& data);
+    static QByteArray volumeFrame(int level, bool muted);
+    static QByteArray progressFrame(const QString& state, int position, int duration);
+    static QByteArray sourceFrame(const QString& id, const QString& friendlyName, const QString& productJid,
+                                  const QString& productName);
+    static QByteArray storedMusicFrame(const QString& title, const QString& artist, const QString& album,
+                                       const QString& imageUrl);
+    static QByteArray netRadioFrame(const QString& name, const QString& liveDescription, const QString& imageUrl);
+    static QByteArray standbyFrame(bool on);
+    static QByteArray shutdownFrame();
+};
@@ -0,0 +1,6 @@
+# Stand-in for a Bang & Olufsen product, included by the tests and the stand-in tool
+INCLUDEPATH += $$PWD
+HEADERS  += $$PWD/beostandin.h \
+            $$PWD/notificationtrace.h
+SOURCES  += $$PWD/beostandin.cpp \
+            $$PWD/notificationtrace.cpp
@@ -0,0 +1,12 @@
+# beo-standin: serves a local stand-in product for manual tests of the integration, e.g.
+#   beo-standin --port 8080 --trace ../traces/playback.trace --speed 10 --loop
+# and configure the product with the address 127.0.0.1:8080.
+TEMPLATE  = app
+TARGET    = beo-standin
+QT       += core network
+QT       -= gui
+CONFIG   += c++14 console testcase_targets
+CONFIG   -= app_bundle
+
+include(standin.pri)
+SOURCES  += main.cpp
@@ -0,0 +1,13 @@
+# Common settings of the test targets
+QT       += core network testlib
+QT       -= gui
+CONFIG   += c++14 console testcase testcase_targets
+CONFIG   -= app_bundle
+
+SRC_PATH = $$clean_path($$PWD/../src)
+INCLUDEPATH += $$SRC_PATH
+
+# recorded notification traces
+DEFINES += TRACE_DIR=\\\"$$PWD/traces\\\"
+
+include(standin/standin.pri)
@@ -0,0 +1,23 @@
+# Tests of the Bang & Olufsen integration, run with "make check".
+# The unit tests only need Qt, the components under test are plain Qt Core and Network.
+# The benchmark and the soak test drive whole products and need the integrations.library project,
+# "make benchmark" and "make soak" run them.
+TEMPLATE  = subdirs
+# check and benchmark targets in every subdirectory
+CONFIG   += testcase_targets
+SUBDIRS   = standin \
+            unit
+
+include($$PWD/integrations.pri)
+exists($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    SUBDIRS += benchmark \
+               soak
+
+    # "make soak" in the soak subdirectory, it is not part of "make check"
+    soaktest.target = soak
+    soaktest.CONFIG = recursive
+    soaktest.recurse = soak
+    QMAKE_EXTRA_TARGETS += soaktest
+} else {
+    message("integrations.library not found in '$$INTG_LIB_PATH', the tests of whole products are skipped")
+}
@@ -0,0 +1,10 @@
+include(../../tests.pri)
+
+TARGET    = tst_beohttpclient
+HEADERS  += $$SRC_PATH/beohttpclient.h \
+            $$SRC_PATH/beometrics.h \
+            $$SRC_PATH/notificationdecoder.h
+SOURCES  += $$SRC_PATH/beohttpclient.cpp \
+            $$SRC_PATH/beometrics.cpp \
+            $$SRC_PATH/notificationdecoder.cpp \
+            tst_beohttpclient.cpp
@@ -0,0 +1,264 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QNetworkProxy>
+#include <QtTest>
+
+#include <algorithm>
+
+#include "beohttpclient.h"
+#include "beostandin.h"
+
+class TestBeoHttpClient : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void ok();
+    void httpError();
+    void connectionRefused();
+    void conditionalRequest();
+    void orderedPerResource();
+    void priorities();
+    void timeout();
+    void cancelAll();
+    void sendWhileCancelling();
+
+ private:
+    BeoResponse get(const QString &path);
+
+    BeoStandIn *           m_standIn = nullptr;
+    QNetworkAccessManager *m_manager = nullptr;
+    BeoHttpClient *        m_client = nullptr;
+};
+
+void TestBeoHttpClient::init() {
+    m_standIn = new BeoStandIn(this);
+    QVERIFY(m_standIn->listen());
+    m_manager = new QNetworkAccessManager(this);
+    m_manager->setProxy(QNetworkProxy::NoProxy);
+    m_client = new BeoHttpClient(m_manager, "http://" + m_standIn->address(), this);
+}
+
+void TestBeoHttpClient::cleanup() {
+    delete m_client;
+    delete m_manager;
+    delete m_standIn;
+}
+
+BeoResponse TestBeoHttpClient::get(const QString &path) {
+    BeoResponse result;
+    bool        done = false;
+    m_client->get(path, [&](const BeoResponse &response) {
+        result = response;
+        done = true;
+    });
+    QTest::qWaitFor([&]() { return done; }, 5000);
+    return result;
+}
+
+void TestBeoHttpClient::ok() {
+    BeoResponse response = get("/BeoZone/Zone/Sound/Volume");
+    QCOMPARE(response.status, BeoResponse::OK);
+    QCOMPARE(response.httpStatus, 200);
+
+    QJsonObject object;
+    QVERIFY(response.parseJson(&object));
+    QCOMPARE(object.value("volume").toObject().value("speaker").toObject().value("level").toInt(), 30);
+    QCOMPARE(m_client->inFlightCount(), 0);
+}
+
+void TestBeoHttpClient::httpError() {
+    BeoResponse response = get("/BeoZone/Zone/Unknown");
+    QCOMPARE(response.status, BeoResponse::HTTP_ERROR);
+    QCOMPARE(response.httpStatus, 404);
+
+    m_standIn->setErrorStatus("/BeoZone/Zone/Sound", 503);
+    response = get("/BeoZone/Zone/Sound/Volume");
+    QCOMPARE(response.status, BeoResponse::HTTP_ERROR);
+    QCOMPARE(response.httpStatus, 503);
+}
+
+void TestBeoHttpClient::connectionRefused() {
+    m_standIn->setOffline(true);
+    BeoResponse response = get("/BeoDevice");
+    QCOMPARE(response.status, BeoResponse::NETWORK_ERROR);
+    QVERIFY(!response.errorString.isEmpty());
+}
+
+void TestBeoHttpClient::conditionalRequest() {
+    BeoResponse response = get("/BeoZone/Zone/Sources");
+    QVERIFY(response.isOk());
+    QVERIFY(!response.etag.isEmpty());
+    QVERIFY(!response.isNotModified());
+
+    BeoHttpClient::Options options;
+    options.headers.insert("If-None-Match", response.etag);
+    bool done = false;
+    m_client->send(QNetworkAccessManager::GetOperation, "/BeoZone/Zone/Sources", QByteArray(), options,
+                   [&](const BeoResponse &conditional) {
+                       QVERIFY(conditional.isNotModified());
+                       done = true;
+                   });
+    QTRY_VERIFY(done);
+}
+
+void TestBeoHttpClient::orderedPerResource() {
+    m_standIn->setResponseDelay(50);
+
+    QList<int> answered;
+    for (int level = 10; level < 15; level++) {
+        m_client->put("/BeoZone/Zone/Sound/Volume/Speaker/Level", QString("{\"level\":%1}").arg(level).toUtf8(),
+                      [&answered, level](const BeoResponse &response) {
+                          if (response.isOk()) {
+                              answered.append(level);
+                          }
+                      });
+    }
+    // one after the other, the product sees the last level last
+    QCOMPARE(m_client->inFlightCount(), 1);
+    QTRY_COMPARE(answered, QList<int>({10, 11, 12, 13, 14}));
+    QCOMPARE(m_standIn->volume(), 14);
+}
+
+void TestBeoHttpClient::priorities() {
+    m_standIn->setResponseDelay(200);
+
+    int  answered = 0;
+    auto handler = [&](const BeoResponse &response) {
+        if (response.isOk()) {
+            answered++;
+        }
+    };
+
+    BeoHttpClient::Options background;
+    background.priority = BeoHttpClient::BACKGROUND;
+    for (int i = 0; i < 3; i++) {
+        m_client->send(QNetworkAccessManager::GetOperation, QString("/BeoDevice?n=%1").arg(i), QByteArray(),
+                       background, handler);
+    }
+    // background requests leave slots free, and run one after the other on the same resource
+    QCOMPARE(m_client->inFlightCount(), 1);
+
+    BeoHttpClient::Options normal;
+    for (const char *path : {"/BeoZone/Zone", "/BeoZone/Zone/Sound/Volume", "/BeoZone/Zone/ActiveSources"}) {
+        m_client->send(QNetworkAccessManager::GetOperation, path, QByteArray(), normal, handler);
+    }
+    QCOMPARE(m_client->inFlightCount(), BeoHttpClient::MAX_IN_FLIGHT - 1);
+    QCOMPARE(m_client->queuedCount(), 3);
+
+    // a command always finds a free slot
+    BeoHttpClient::Options interactive;
+    interactive.priority = BeoHttpClient::INTERACTIVE;
+    m_client->send(QNetworkAccessManager::PostOperation, "/BeoZone/Zone/Stream/Play", QByteArray(), interactive,
+                   handler);
+    QCOMPARE(m_client->inFlightCount(), int(BeoHttpClient::MAX_IN_FLIGHT));
+
+    QTRY_COMPARE_WITH_TIMEOUT(answered, 7, 10000);
+    QCOMPARE(m_client->inFlightCount(), 0);
+    QCOMPARE(m_client->queuedCount(), 0);
+}
+
+void TestBeoHttpClient::timeout() {
+    m_standIn->setUnresponsive(true);
+
+    BeoHttpClient::Options options;
+    options.timeout = 300;
+    QElapsedTimer       timer;
+    BeoResponse::Status status = BeoResponse::OK;
+    bool                done = false;
+    timer.start();
+    m_client->send(QNetworkAccessManager::GetOperation, "/BeoDevice", QByteArray(), options,
+                   [&](const BeoResponse &response) {
+                       status = response.status;
+                       done = true;
+                   });
+    QTRY_VERIFY_WITH_TIMEOUT(done, 3000);
+    QCOMPARE(status, BeoResponse::TIMEOUT);
+    // checked by a timer with a 500 ms interval
+    QVERIFY(timer.elapsed() >= 300);
+    QCOMPARE(m_client->inFlightCount(), 0);
+}
+
+void TestBeoHttpClient::cancelAll() {
+    m_standIn->setResponseDelay(200);
+
+    QHash<quint64, int>        calls;
+    QList<BeoResponse::Status> statuses;
+    auto                       handler = [&](const BeoResponse &response) {
+        calls[response.id]++;
+        statuses.append(response.status);
+    };
+    for (int i = 0; i < 8; i++) {
+        m_client->get(QString("/BeoZone/Zone?n=%1").arg(i), handler);
+    }
+    m_client->cancelAll();
+
+    QCOMPARE(statuses.size(), 8);
+    QVERIFY(std::all_of(statuses.cbegin(), statuses.cend(),
+                        [](BeoResponse::Status status) { return status == BeoResponse::CANCELLED; }));
+    QCOMPARE(m_client->inFlightCount(), 0);
+    QCOMPARE(m_client->queuedCount(), 0);
+
+    // no late answers of the aborted replies
+    QTest::qWait(400);
+    QCOMPARE(statuses.size(), 8);
+    for (int count : calls) {
+        QCOMPARE(count, 1);
+    }
+}
+
+void TestBeoHttpClient::sendWhileCancelling() {
+    m_standIn->setResponseDelay(200);
+
+    // a handler that sends a follow-up request, e.g. a query after a failed command
+    QList<BeoResponse::Status> statuses;
+    QList<BeoResponse::Status> followUps;
+    for (int i = 0; i < 2; i++) {
+        m_client->get("/BeoZone/Zone", [&](const BeoResponse &response) {
+            statuses.append(response.status);
+            m_client->get("/BeoZone/Zone/ActiveSources",
+                          [&](const BeoResponse &followUp) { followUps.append(followUp.status); });
+        });
+    }
+    m_client->cancelAll();
+
+    QCOMPARE(statuses.size(), 2);
+    QCOMPARE(followUps.size(), 2);
+    QVERIFY(std::all_of(followUps.cbegin(), followUps.cend(),
+                        [](BeoResponse::Status status) { return status == BeoResponse::CANCELLED; }));
+    QCOMPARE(m_client->inFlightCount(), 0);
+    QCOMPARE(m_client->queuedCount(), 0);
+
+    // nothing reached the product after the cancel
+    QTest::qWait(400);
+    QCOMPARE(m_standIn->requestCount("/BeoZone/Zone/ActiveSources"), 0);
+    QCOMPARE(followUps.size(), 2);
+
+    // the client takes requests again
+    QCOMPARE(get("/BeoZone/Zone").status, BeoResponse::OK);
+}
+
+QTEST_GUILESS_MAIN(TestBeoHttpClient)
+#include "tst_beohttpclient.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET    = tst_beostandin
+HEADERS  += $$SRC_PATH/notificationframer.h
+SOURCES  += $$SRC_PATH/notificationframer.cpp \
+            tst_beostandin.cpp
@@ -0,0 +1,212 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QDir>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QtTest>
+
+#include "beostandin.h"
+#include "notificationframer.h"
+
+/// Reads the notification stream of the stand-in the way the integration does.
+class StreamClient : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit StreamClient(const QString &address, QObject *parent = nullptr) : QObject(parent) {
+        m_manager.setProxy(QNetworkProxy::NoProxy);
+        m_reply = m_manager.get(QNetworkRequest(QUrl("http://" + address + "/BeoNotify/Notifications")));
+        QObject::connect(m_reply, &QNetworkReply::readyRead, this, [this]() {
+            reads++;
+            m_framer.feed(m_reply->readAll(), [this](const QByteArray &frame) {
+                frames.append(QByteArray(frame.constData(), frame.size()));
+            });
+        });
+    }
+
+    QStringList types() const {
+        QStringList result;
+        for (const QByteArray &frame : frames) {
+            result.append(NotificationTrace::typeOf(frame));
+        }
+        return result;
+    }
+
+    bool isFinished() const { return m_reply->isFinished(); }
+
+    QList<QByteArray> frames;
+    int               reads = 0;
+
+ private:
+    QNetworkAccessManager m_manager;
+    QNetworkReply *       m_reply;
+    NotificationFramer    m_framer;
+};
+
+class TestBeoStandIn : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void initialState();
+    void commandsAreNotified();
+    void splitFrames();
+    void stall();
+    void dropConnections();
+    void replay();
+    void replaySpeed();
+    void traceFiles();
+
+ private:
+    BeoStandIn *  m_standIn = nullptr;
+    StreamClient *m_stream = nullptr;
+};
+
+void TestBeoStandIn::init() {
+    m_standIn = new BeoStandIn(this);
+    QVERIFY(m_standIn->listen());
+    m_stream = new StreamClient(m_standIn->address(), this);
+    QTRY_COMPARE(m_stream->frames.size(), 3);
+    m_stream->frames.clear();
+    m_stream->reads = 0;
+}
+
+void TestBeoStandIn::cleanup() {
+    delete m_stream;
+    delete m_standIn;
+}
+
+void TestBeoStandIn::initialState() {
+    delete m_stream;
+    m_stream = new StreamClient(m_standIn->address(), this);
+    QTRY_COMPARE(m_stream->types(), QStringList({"VOLUME", "SOURCE", "PROGRESS_INFORMATION"}));
+    QCOMPARE(m_standIn->streamCount(), 1);
+}
+
+void TestBeoStandIn::commandsAreNotified() {
+    QNetworkAccessManager manager;
+    manager.setProxy(QNetworkProxy::NoProxy);
+    QNetworkRequest request(QUrl("http://" + m_standIn->address() + "/BeoZone/Zone/Sound/Volume/Speaker/Level"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    QNetworkReply *reply = manager.put(request, "{\"level\":42}");
+    QTRY_VERIFY(reply->isFinished());
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    reply->deleteLater();
+
+    QTRY_COMPARE(m_stream->types(), QStringList({"VOLUME"}));
+    QCOMPARE(m_standIn->volume(), 42);
+    QCOMPARE(m_standIn->requestCount("/BeoZone/Zone/Sound/Volume/Speaker/Level"), 1);
+}
+
+void TestBeoStandIn::splitFrames() {
+    m_standIn->setSplitSize(7);
+    const QByteArray frame = NotificationTrace::volumeFrame(12, false);
+    m_standIn->sendFrame(frame);
+    m_standIn->sendFrame(NotificationTrace::volumeFrame(13, false));
+
+    QTRY_COMPARE(m_stream->frames.size(), 2);
+    QCOMPARE(m_stream->frames.first(), frame);
+    // every piece arrived in its own read
+    QVERIFY2(m_stream->reads > frame.size() / 7, qPrintable(QString::number(m_stream->reads)));
+}
+
+void TestBeoStandIn::stall() {
+    m_standIn->stallStreams(400);
+    m_standIn->sendFrame(NotificationTrace::volumeFrame(12, false));
+    m_standIn->sendFrame(NotificationTrace::volumeFrame(13, false));
+
+    QTest::qWait(200);
+    QVERIFY(m_stream->frames.isEmpty());
+    QTRY_COMPARE(m_stream->frames.size(), 2);
+}
+
+void TestBeoStandIn::dropConnections() {
+    m_standIn->dropConnections();
+    QTRY_VERIFY(m_stream->isFinished());
+    QCOMPARE(m_standIn->streamCount(), 0);
+    QCOMPARE(m_standIn->connectionCount(), 0);
+
+    // the product takes new connections
+    delete m_stream;
+    m_stream = new StreamClient(m_standIn->address(), this);
+    QTRY_COMPARE(m_stream->frames.size(), 3);
+}
+
+void TestBeoStandIn::replay() {
+    QList<TraceEntry> trace;
+    QVERIFY(NotificationTrace::parse("# comment\n"
+                                     "0 " + NotificationTrace::standbyFrame(true) + "\n"
+                                     "\n"
+                                     "10 " + NotificationTrace::volumeFrame(20, false) + "\n"
+                                     "20 " + NotificationTrace::progressFrame("play", 1, 200) + "\n",
+                                     &trace));
+    QCOMPARE(trace.size(), 3);
+
+    QSignalSpy finished(m_standIn, &BeoStandIn::replayFinished);
+    m_standIn->replay(trace, 0);
+    QTRY_COMPARE(finished.count(), 1);
+    QTRY_COMPARE(m_stream->types(), QStringList({"STANDBY", "VOLUME", "PROGRESS_INFORMATION"}));
+    QVERIFY(!m_standIn->isReplaying());
+
+    QString errorString;
+    QVERIFY(!NotificationTrace::parse("later {}\n", &trace, &errorString));
+    QVERIFY(!errorString.isEmpty());
+}
+
+void TestBeoStandIn::replaySpeed() {
+    QList<TraceEntry> trace;
+    for (int i = 0; i <= 10; i++) {
+        trace.append(TraceEntry{i * 400, NotificationTrace::volumeFrame(i, false)});
+    }
+
+    // 4 s of recording at ten times the speed
+    QElapsedTimer timer;
+    timer.start();
+    m_standIn->replay(trace, 10);
+    QTRY_COMPARE_WITH_TIMEOUT(m_stream->frames.size(), trace.size(), 5000);
+    QVERIFY2(timer.elapsed() >= 350, qPrintable(QString::number(timer.elapsed())));
+}
+
+void TestBeoStandIn::traceFiles() {
+    const QStringList files = QDir(TRACE_DIR).entryList({"*.trace"}, QDir::Files);
+    QVERIFY(!files.isEmpty());
+
+    for (const QString &file : files) {
+        QList<TraceEntry> trace;
+        QString           errorString;
+        QVERIFY2(NotificationTrace::load(QDir(TRACE_DIR).filePath(file), &trace, &errorString),
+                 qPrintable(file + ": " + errorString));
+        qint64 offset = 0;
+        for (const TraceEntry &entry : trace) {
+            QVERIFY2(!NotificationTrace::typeOf(entry.frame).isEmpty(), qPrintable(file));
+            QVERIFY2(entry.offset >= offset, qPrintable(file + ": offsets must not go back"));
+            offset = entry.offset;
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestBeoStandIn)
+#include "tst_beostandin.moc"
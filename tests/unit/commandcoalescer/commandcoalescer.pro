@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET    = tst_commandcoalescer
+HEADERS  += $$SRC_PATH/commandcoalescer.h
+SOURCES  += $$SRC_PATH/commandcoalescer.cpp \
+            tst_commandcoalescer.cpp
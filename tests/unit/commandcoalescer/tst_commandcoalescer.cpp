@@ -0,0 +1,130 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QtTest>
+
+#include "commandcoalescer.h"
+
+class TestCommandCoalescer : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void sendsImmediately();
+    void latestWins();
+    void failureReachesWaiters();
+    void reset();
+};
+
+/// Records the sent values, the requests are answered by the test.
+struct FakeSender {
+    QList<QVariant>                       sent;
+    QList<CommandCoalescer::DoneCallback> answers;
+
+    CommandCoalescer::SendFunction function() {
+        return [this](const QVariant &value, const CommandCoalescer::DoneCallback &done) {
+            sent.append(value);
+            answers.append(done);
+        };
+    }
+
+    void answer(bool success) { answers.takeFirst()(success); }
+};
+
+void TestCommandCoalescer::sendsImmediately() {
+    FakeSender       sender;
+    CommandCoalescer coalescer(sender.function());
+    bool             done = false;
+
+    coalescer.submit(10, [&](bool success) { done = success; });
+    QCOMPARE(sender.sent, QList<QVariant>({10}));
+    QVERIFY(coalescer.isBusy());
+    QCOMPARE(coalescer.targetValue(), QVariant(10));
+
+    sender.answer(true);
+    QVERIFY(done);
+    QVERIFY(!coalescer.isBusy());
+    QVERIFY(!coalescer.targetValue().isValid());
+}
+
+void TestCommandCoalescer::latestWins() {
+    FakeSender       sender;
+    CommandCoalescer coalescer(sender.function());
+    QList<int>       done;
+
+    for (int value = 1; value <= 5; value++) {
+        coalescer.submit(value, [&done, value](bool success) {
+            if (success) {
+                done.append(value);
+            }
+        });
+    }
+    // one request in flight, the values submitted meanwhile replaced each other
+    QCOMPARE(sender.sent, QList<QVariant>({1}));
+    QCOMPARE(coalescer.targetValue(), QVariant(5));
+
+    sender.answer(true);
+    QCOMPARE(done, QList<int>({1}));
+    QCOMPARE(sender.sent, QList<QVariant>({1, 5}));
+
+    sender.answer(true);
+    QCOMPARE(done, QList<int>({1, 2, 3, 4, 5}));
+    QVERIFY(!coalescer.isBusy());
+    QVERIFY(sender.answers.isEmpty());
+}
+
+void TestCommandCoalescer::failureReachesWaiters() {
+    FakeSender       sender;
+    CommandCoalescer coalescer(sender.function());
+    QList<bool>      results;
+
+    coalescer.submit(1, [&](bool success) { results.append(success); });
+    coalescer.submit(2, [&](bool success) { results.append(success); });
+    sender.answer(false);
+    // the pending value is still sent
+    QCOMPARE(sender.sent, QList<QVariant>({1, 2}));
+    sender.answer(true);
+
+    QCOMPARE(results, QList<bool>({false, true}));
+}
+
+void TestCommandCoalescer::reset() {
+    FakeSender       sender;
+    CommandCoalescer coalescer(sender.function());
+    QList<bool>      results;
+
+    coalescer.submit(1, [&](bool success) { results.append(success); });
+    coalescer.submit(2, [&](bool success) { results.append(success); });
+    coalescer.reset();
+    QCOMPARE(results, QList<bool>({false, false}));
+    QVERIFY(!coalescer.isBusy());
+
+    // the late answer of the old request is ignored
+    sender.answer(true);
+    QCOMPARE(results.size(), 2);
+    QCOMPARE(sender.sent.size(), 1);
+
+    coalescer.submit(3);
+    QCOMPARE(sender.sent, QList<QVariant>({1, 3}));
+}
+
+QTEST_GUILESS_MAIN(TestCommandCoalescer)
+#include "tst_commandcoalescer.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET    = tst_notificationdecoder
+HEADERS  += $$SRC_PATH/notificationdecoder.h
+SOURCES  += $$SRC_PATH/notificationdecoder.cpp \
+            tst_notificationdecoder.cpp
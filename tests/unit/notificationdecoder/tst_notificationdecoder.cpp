@@ -0,0 +1,160 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QtTest>
+
+#include "notificationdecoder.h"
+#include "notificationtrace.h"
+
+Q_DECLARE_METATYPE(BeoNotification::Type)
+
+class TestNotificationDecoder : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void volume();
+    void source();
+    void progress();
+    void music();
+    void power();
+    void invalidFrames();
+    void peekType_data();
+    void peekType();
+};
+
+static BeoNotification decoded(const QByteArray &frame) {
+    BeoNotification notification;
+    QString         errorString;
+    bool            ok = NotificationDecoder::decode(frame, &notification, &errorString);
+    if (!ok) {
+        qWarning() << "Decoding failed:" << errorString;
+    }
+    return notification;
+}
+
+void TestNotificationDecoder::volume() {
+    BeoNotification notification = decoded(NotificationTrace::volumeFrame(42, true));
+    QCOMPARE(notification.type, BeoNotification::VOLUME);
+    QCOMPARE(notification.volume.level, 42);
+    QCOMPARE(notification.volume.muted, true);
+}
+
+void TestNotificationDecoder::source() {
+    const QString   jid = "2714.1200306.28096312@products.bang-olufsen.com";
+    BeoNotification notification =
+        decoded(NotificationTrace::sourceFrame("radio:" + jid, "TuneIn", jid, "Living Room"));
+    QCOMPARE(notification.type, BeoNotification::SOURCE);
+    QCOMPARE(notification.source.id, "radio:" + jid);
+    QCOMPARE(notification.source.friendlyName, QString("TuneIn"));
+    QCOMPARE(notification.source.productJid, jid);
+    QCOMPARE(notification.source.productName, QString("Living Room"));
+    QCOMPARE(notification.source.listeners, QStringList({jid}));
+}
+
+void TestNotificationDecoder::progress() {
+    BeoNotification notification = decoded(NotificationTrace::progressFrame("pause", 61, 240));
+    QCOMPARE(notification.type, BeoNotification::PROGRESS_INFORMATION);
+    QCOMPARE(notification.progress.state, BeoProgress::PAUSE);
+    QCOMPARE(notification.progress.position, 61);
+    QCOMPARE(notification.progress.duration, 240);
+
+    QCOMPARE(decoded(NotificationTrace::progressFrame("preparing", 0, 0)).progress.state, BeoProgress::UNKNOWN);
+}
+
+void TestNotificationDecoder::music() {
+    BeoNotification stored = decoded(
+        NotificationTrace::storedMusicFrame("Title", "Artist", "Album", "http://127.0.0.1/art/cover.jpg"));
+    QCOMPARE(stored.type, BeoNotification::NOW_PLAYING_STORED_MUSIC);
+    QCOMPARE(stored.music.title, QString("Title"));
+    QCOMPARE(stored.music.artist, QString("Artist"));
+    QCOMPARE(stored.music.album, QString("Album"));
+    QCOMPARE(stored.music.imageUrl, QString("http://127.0.0.1/art/cover.jpg"));
+
+    BeoNotification radio =
+        decoded(NotificationTrace::netRadioFrame("Radio 1", "Live show", "http://127.0.0.1/art/radio.png"));
+    QCOMPARE(radio.type, BeoNotification::NOW_PLAYING_NET_RADIO);
+    QCOMPARE(radio.music.artist, QString("Radio 1"));
+    QCOMPARE(radio.music.title, QString("Live show"));
+    QCOMPARE(radio.music.imageUrl, QString("http://127.0.0.1/art/radio.png"));
+}
+
+void TestNotificationDecoder::power() {
+    QCOMPARE(decoded(NotificationTrace::standbyFrame(true)).power.on, true);
+    QCOMPARE(decoded(NotificationTrace::standbyFrame(false)).power.on, false);
+
+    BeoNotification shutdown = decoded(NotificationTrace::shutdownFrame());
+    QCOMPARE(shutdown.type, BeoNotification::SHUTDOWN);
+    QCOMPARE(shutdown.power.on, false);
+}
+
+void TestNotificationDecoder::invalidFrames() {
+    BeoNotification notification;
+    QString         errorString;
+    QVERIFY(!NotificationDecoder::decode("{\"notification\":", &notification, &errorString));
+    QVERIFY(!errorString.isEmpty());
+
+    // unhandled types are valid
+    QVERIFY(NotificationDecoder::decode(NotificationTrace::frame("TIMER", QJsonObject()), &notification));
+    QCOMPARE(notification.type, BeoNotification::UNKNOWN);
+}
+
+void TestNotificationDecoder::peekType_data() {
+    QTest::addColumn<QByteArray>("frame");
+    QTest::addColumn<bool>("found");
+    QTest::addColumn<BeoNotification::Type>("type");
+
+    QTest::newRow("volume") << NotificationTrace::volumeFrame(10, false) << true << BeoNotification::VOLUME;
+    QTest::newRow("unknown") << NotificationTrace::frame("TIMER", QJsonObject()) << true << BeoNotification::UNKNOWN;
+    QTest::newRow("whitespace") << QByteArray("{ \"notification\" : { \"type\" : \"STANDBY\" , \"data\" : {} } }")
+                                << true << BeoNotification::STANDBY;
+
+    // the data comes before the type in sorted keys, its own "type" must not be taken
+    QJsonObject nested;
+    nested.insert("type", "VOLUME");
+    QTest::newRow("type in data") << NotificationTrace::frame("SOURCE", nested) << true << BeoNotification::SOURCE;
+    QTest::newRow("type as value") << QByteArray("{\"notification\":{\"kind\":\"type\",\"type\":\"SHUTDOWN\"}}") << true
+                                   << BeoNotification::SHUTDOWN;
+    QTest::newRow("escaped quote") << QByteArray("{\"notification\":{\"id\":\"a\\\"b\",\"type\":\"VOLUME\"}}") << true
+                                   << BeoNotification::VOLUME;
+
+    QTest::newRow("no type") << QByteArray("{\"notification\":{\"data\":{}}}") << false << BeoNotification::UNKNOWN;
+    QTest::newRow("truncated") << QByteArray("{\"notification\":{\"type\":\"VOL") << false << BeoNotification::UNKNOWN;
+}
+
+void TestNotificationDecoder::peekType() {
+    QFETCH(QByteArray, frame);
+    QFETCH(bool, found);
+    QFETCH(BeoNotification::Type, type);
+
+    BeoNotification::Type peeked = BeoNotification::UNKNOWN;
+    QCOMPARE(NotificationDecoder::peekType(frame, &peeked), found);
+    if (found) {
+        QCOMPARE(peeked, type);
+        // the same answer as the full decoder
+        BeoNotification notification;
+        QVERIFY(NotificationDecoder::decode(frame, &notification));
+        QCOMPARE(notification.type, type);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestNotificationDecoder)
+#include "tst_notificationdecoder.moc"
@@ -0,0 +1,8 @@
+include(../../tests.pri)
+
+TARGET    = tst_notificationfilter
+HEADERS  += $$SRC_PATH/notificationdecoder.h \
+            $$SRC_PATH/notificationfilter.h
+SOURCES  += $$SRC_PATH/notificationdecoder.cpp \
+            $$SRC_PATH/notificationfilter.cpp \
+            tst_notificationfilter.cpp
@@ -0,0 +1,170 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QtTest>
+
+#include "notificationfilter.h"
+#include "notificationtrace.h"
+
+class TestNotificationFilter : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void passByDefault();
+    void policyFromVariant();
+    void sample();
+    void sampleReleasesLast();
+    void latestOnly();
+    void clear();
+};
+
+static NotificationFilter::Policies policies(BeoNotification::Type type, NotificationFilter::Action action,
+                                             int interval = 0) {
+    NotificationFilter::Policy policy;
+    policy.action = action;
+    policy.interval = interval;
+    NotificationFilter::Policies result;
+    result.insert(type, policy);
+    return result;
+}
+
+void TestNotificationFilter::passByDefault() {
+    NotificationFilter filter;
+    for (int i = 0; i < 100; i++) {
+        QVERIFY(filter.accept(BeoNotification::PROGRESS_INFORMATION, NotificationTrace::progressFrame("play", i, 0)));
+    }
+}
+
+void TestNotificationFilter::policyFromVariant() {
+    NotificationFilter::Policy policy;
+    QVERIFY(NotificationFilter::policyFromVariant("latest", &policy));
+    QCOMPARE(policy.action, NotificationFilter::LATEST_ONLY);
+    QVERIFY(NotificationFilter::policyFromVariant(500, &policy));
+    QCOMPARE(policy.action, NotificationFilter::SAMPLE);
+    QCOMPARE(policy.interval, 500);
+    QVERIFY(NotificationFilter::policyFromVariant("pass", &policy));
+    QCOMPARE(policy.action, NotificationFilter::PASS);
+
+    QVERIFY(!NotificationFilter::policyFromVariant("sometimes", &policy));
+    QVERIFY(!NotificationFilter::policyFromVariant(0, &policy));
+}
+
+void TestNotificationFilter::sample() {
+    NotificationFilter filter;
+    filter.setPolicies(policies(BeoNotification::PROGRESS_INFORMATION, NotificationFilter::SAMPLE, 200),
+                       [](const QByteArray &) {});
+
+    const QByteArray frame = NotificationTrace::progressFrame("play", 1, 0);
+    QVERIFY(filter.accept(BeoNotification::PROGRESS_INFORMATION, frame));
+    QVERIFY(!filter.accept(BeoNotification::PROGRESS_INFORMATION, frame));
+    // other types are not affected
+    QVERIFY(filter.accept(BeoNotification::VOLUME, NotificationTrace::volumeFrame(1, false)));
+
+    QTest::qWait(250);
+    QVERIFY(filter.accept(BeoNotification::PROGRESS_INFORMATION, frame));
+}
+
+void TestNotificationFilter::sampleReleasesLast() {
+    NotificationFilter filter;
+    filter.setPolicies(policies(BeoNotification::VOLUME, NotificationFilter::SAMPLE, 200), [](const QByteArray &) {});
+    QCOMPARE(filter.msecsToRelease(), qint64(-1));
+
+    // a volume knob turned from 30 to 40, only the first frame passes at once
+    QVERIFY(filter.accept(BeoNotification::VOLUME, NotificationTrace::volumeFrame(30, false)));
+    for (int level = 31; level <= 40; level++) {
+        QVERIFY(!filter.accept(BeoNotification::VOLUME, NotificationTrace::volumeFrame(level, false)));
+    }
+    QVERIFY(filter.msecsToRelease() >= 0);
+    QVERIFY(filter.msecsToRelease() <= 200);
+
+    QList<QByteArray> released;
+    auto              handler = [&](const QByteArray &frame) { released.append(frame); };
+    filter.releaseDue(handler);
+    QVERIFY(released.isEmpty());
+
+    // the last frame of the burst comes out when the interval expired
+    QTest::qWait(250);
+    QCOMPARE(filter.msecsToRelease(), qint64(0));
+    filter.releaseDue(handler);
+    QCOMPARE(released.size(), 1);
+    BeoNotification notification;
+    QVERIFY(NotificationDecoder::decode(released.at(0), &notification));
+    QCOMPARE(notification.volume.level, 40);
+    QCOMPARE(filter.msecsToRelease(), qint64(-1));
+
+    // and when the policies change before, e.g. a sampled pause while the player becomes visible
+    filter.setPolicies(policies(BeoNotification::PROGRESS_INFORMATION, NotificationFilter::SAMPLE, 10000),
+                       [](const QByteArray &) {});
+    QVERIFY(filter.accept(BeoNotification::PROGRESS_INFORMATION, NotificationTrace::progressFrame("play", 1, 0)));
+    QVERIFY(!filter.accept(BeoNotification::PROGRESS_INFORMATION, NotificationTrace::progressFrame("pause", 2, 0)));
+    released.clear();
+    filter.setPolicies(NotificationFilter::Policies(), handler);
+    QCOMPARE(released.size(), 1);
+    QVERIFY(NotificationDecoder::decode(released.at(0), &notification));
+    QCOMPARE(notification.progress.state, BeoProgress::PAUSE);
+}
+
+void TestNotificationFilter::latestOnly() {
+    NotificationFilter filter;
+    NotificationFilter::Policies held =
+        policies(BeoNotification::NOW_PLAYING_STORED_MUSIC, NotificationFilter::LATEST_ONLY);
+    held.insert(BeoNotification::PROGRESS_INFORMATION, held.value(BeoNotification::NOW_PLAYING_STORED_MUSIC));
+    filter.setPolicies(held, [](const QByteArray &) {});
+
+    QByteArray progress = NotificationTrace::progressFrame("play", 10, 0);
+    QVERIFY(!filter.accept(BeoNotification::NOW_PLAYING_STORED_MUSIC,
+                           NotificationTrace::storedMusicFrame("First", "Artist", "Album", QString())));
+    QVERIFY(!filter.accept(BeoNotification::PROGRESS_INFORMATION, progress));
+    QVERIFY(!filter.accept(BeoNotification::NOW_PLAYING_STORED_MUSIC,
+                           NotificationTrace::storedMusicFrame("Second", "Artist", "Album", QString())));
+    // the held frame is a copy, not a reference to the stream buffer
+    progress.fill(' ');
+
+    QList<QByteArray> released;
+    filter.setPolicies(NotificationFilter::Policies(), [&](const QByteArray &frame) { released.append(frame); });
+
+    // only the newest frame of each type, in the order they arrived
+    QCOMPARE(released.size(), 2);
+    QCOMPARE(NotificationTrace::typeOf(released.at(0)), QString("PROGRESS_INFORMATION"));
+    BeoNotification notification;
+    QVERIFY(NotificationDecoder::decode(released.at(1), &notification));
+    QCOMPARE(notification.music.title, QString("Second"));
+
+    // nothing is held any more
+    released.clear();
+    filter.setPolicies(NotificationFilter::Policies(), [&](const QByteArray &frame) { released.append(frame); });
+    QVERIFY(released.isEmpty());
+}
+
+void TestNotificationFilter::clear() {
+    NotificationFilter filter;
+    filter.setPolicies(policies(BeoNotification::VOLUME, NotificationFilter::LATEST_ONLY), [](const QByteArray &) {});
+    QVERIFY(!filter.accept(BeoNotification::VOLUME, NotificationTrace::volumeFrame(1, false)));
+    filter.clear();
+
+    int released = 0;
+    filter.setPolicies(NotificationFilter::Policies(), [&](const QByteArray &) { released++; });
+    QCOMPARE(released, 0);
+}
+
+QTEST_GUILESS_MAIN(TestNotificationFilter)
+#include "tst_notificationfilter.moc"
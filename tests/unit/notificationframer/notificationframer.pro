@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET    = tst_notificationframer
+HEADERS  += $$SRC_PATH/notificationframer.h
+SOURCES  += $$SRC_PATH/notificationframer.cpp \
+            tst_notificationframer.cpp
@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QtTest>
+
+#include "notificationframer.h"
+
+class TestNotificationFramer : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void completeFrames();
+    void frameSplitOverReads_data();
+    void frameSplitOverReads();
+    void whitespaceAndEmptyFrames();
+    void overflow();
+    void clearInHandler();
+};
+
+void TestNotificationFramer::completeFrames() {
+    NotificationFramer framer;
+    QList<QByteArray>  frames;
+    framer.feed("{\"a\":1}\r\n\r\n{\"b\":2}\r\n\r\n", [&](const QByteArray &frame) { frames.append(frame); });
+
+    QCOMPARE(frames, QList<QByteArray>({"{\"a\":1}", "{\"b\":2}"}));
+    QCOMPARE(framer.pendingBytes(), 0);
+}
+
+void TestNotificationFramer::frameSplitOverReads_data() {
+    QTest::addColumn<int>("pieceSize");
+    for (int size : {1, 2, 3, 4, 5, 7, 64}) {
+        QTest::addRow("%d bytes", size) << size;
+    }
+}
+
+void TestNotificationFramer::frameSplitOverReads() {
+    QFETCH(int, pieceSize);
+
+    // every split position, the delimiter included
+    const QByteArray  stream = "{\"first\":true}\r\n\r\n{\"second\":\"\\r\\n\"}\r\n\r\n{\"third\":3}\r\n\r\n{\"part";
+    NotificationFramer framer;
+    QList<QByteArray>  frames;
+    for (int i = 0; i < stream.size(); i += pieceSize) {
+        // copies, the framer must not keep references to the network data
+        QVERIFY(framer.feed(QByteArray(stream.mid(i, pieceSize)), [&](const QByteArray &frame) {
+            frames.append(QByteArray(frame.constData(), frame.size()));
+        }));
+    }
+
+    QCOMPARE(frames, QList<QByteArray>({"{\"first\":true}", "{\"second\":\"\\r\\n\"}", "{\"third\":3}"}));
+    QCOMPARE(framer.pendingBytes(), 6);
+}
+
+void TestNotificationFramer::whitespaceAndEmptyFrames() {
+    NotificationFramer framer;
+    QList<QByteArray>  frames;
+    framer.feed("\r\n\r\n  {\"a\":1} \n\r\n\r\n\r\n\r\n", [&](const QByteArray &frame) { frames.append(frame); });
+
+    QCOMPARE(frames, QList<QByteArray>({"{\"a\":1}"}));
+}
+
+void TestNotificationFramer::overflow() {
+    NotificationFramer framer(16);
+    int                count = 0;
+    auto               handler = [&](const QByteArray &) { count++; };
+
+    QVERIFY(framer.feed("{\"a\":", handler));
+    QVERIFY(!framer.feed("\"a frame without an end\"", handler));
+    QCOMPARE(framer.overflowCount(), 1);
+    QCOMPARE(framer.pendingBytes(), 0);
+
+    // the tail of the dropped frame is passed on and rejected by the decoder, the next frame is complete again
+    QVERIFY(framer.feed("}\r\n\r\n{\"b\":2}\r\n\r\n", handler));
+    QCOMPARE(count, 2);
+}
+
+void TestNotificationFramer::clearInHandler() {
+    NotificationFramer framer;
+    QList<QByteArray>  frames;
+    framer.feed("{\"a\":1}\r\n\r\n{\"b\":2}\r\n\r\n{\"c\":", [&](const QByteArray &frame) {
+        frames.append(QByteArray(frame.constData(), frame.size()));
+        framer.clear();
+    });
+
+    QCOMPARE(frames, QList<QByteArray>({"{\"a\":1}"}));
+    QCOMPARE(framer.pendingBytes(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestNotificationFramer)
+#include "tst_notificationframer.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET    = tst_optimisticstate
+HEADERS  += $$SRC_PATH/optimisticstate.h
+SOURCES  += $$SRC_PATH/optimisticstate.cpp \
+            tst_optimisticstate.cpp
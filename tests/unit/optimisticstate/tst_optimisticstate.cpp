@@ -0,0 +1,154 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QtTest>
+
+#include "optimisticstate.h"
+
+class TestOptimisticState : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void reportWithoutProposal();
+    void confirmedByReport();
+    void notificationBeforeAnswer();
+    void intermediateSteps();
+    void failureRollsBack();
+    void settleRollsBack();
+};
+
+static const int VOLUME = 1;
+
+/// Stands in for the entity, every write is recorded.
+struct FakeEntity {
+    QHash<int, QVariant> values;
+    QList<QVariant>      writes;
+
+    OptimisticState state() {
+        return OptimisticState([this](int attribute) { return values.value(attribute); },
+                               [this](int attribute, const QVariant &value) {
+                                   if (values.value(attribute) == value) {
+                                       return false;
+                                   }
+                                   values.insert(attribute, value);
+                                   writes.append(value);
+                                   return true;
+                               });
+    }
+};
+
+void TestOptimisticState::reportWithoutProposal() {
+    FakeEntity      entity;
+    OptimisticState state = entity.state();
+
+    QVERIFY(state.report(VOLUME, 20));
+    QVERIFY(!state.report(VOLUME, 20));
+    QCOMPARE(entity.writes, QList<QVariant>({20}));
+}
+
+void TestOptimisticState::confirmedByReport() {
+    FakeEntity      entity;
+    OptimisticState state = entity.state();
+    state.report(VOLUME, 20);
+
+    state.propose(VOLUME, 40);
+    QCOMPARE(entity.values.value(VOLUME), QVariant(40));
+    QVERIFY(state.isPending(VOLUME));
+    QCOMPARE(state.pendingValue(VOLUME), QVariant(40));
+
+    state.commandDone(VOLUME, true, 0);
+    QVERIFY(state.isPending(VOLUME));
+    QVERIFY(!state.report(VOLUME, 40));
+    QVERIFY(!state.isPending(VOLUME));
+    QCOMPARE(state.settle(OptimisticState::SETTLE_TIME), qint64(-1));
+    QCOMPARE(entity.writes, QList<QVariant>({20, 40}));
+}
+
+void TestOptimisticState::notificationBeforeAnswer() {
+    FakeEntity      entity;
+    OptimisticState state = entity.state();
+    state.report(VOLUME, 20);
+
+    state.propose(VOLUME, 40);
+    state.report(VOLUME, 40);
+    QVERIFY(state.isPending(VOLUME));
+    state.commandDone(VOLUME, true, 0);
+    QVERIFY(!state.isPending(VOLUME));
+    QCOMPARE(entity.values.value(VOLUME), QVariant(40));
+}
+
+void TestOptimisticState::intermediateSteps() {
+    FakeEntity      entity;
+    OptimisticState state = entity.state();
+    state.report(VOLUME, 20);
+
+    // the product ramps the volume and reports the steps in between
+    state.propose(VOLUME, 40);
+    for (int level = 22; level < 40; level += 2) {
+        QVERIFY(!state.report(VOLUME, level));
+    }
+    QCOMPARE(entity.values.value(VOLUME), QVariant(40));
+
+    // a second command while the first one is running
+    state.propose(VOLUME, 50);
+    state.commandDone(VOLUME, true, 0);
+    state.report(VOLUME, 40);
+    QVERIFY(state.isPending(VOLUME));
+    state.commandDone(VOLUME, true, 0);
+    state.report(VOLUME, 50);
+    QVERIFY(!state.isPending(VOLUME));
+    QCOMPARE(entity.writes, QList<QVariant>({20, 40, 50}));
+}
+
+void TestOptimisticState::failureRollsBack() {
+    FakeEntity      entity;
+    OptimisticState state = entity.state();
+    state.report(VOLUME, 20);
+
+    state.propose(VOLUME, 40);
+    state.report(VOLUME, 24);
+    state.commandDone(VOLUME, false, 0);
+
+    // back to what the product reported last
+    QVERIFY(!state.isPending(VOLUME));
+    QCOMPARE(entity.values.value(VOLUME), QVariant(24));
+}
+
+void TestOptimisticState::settleRollsBack() {
+    FakeEntity      entity;
+    OptimisticState state = entity.state();
+    state.report(VOLUME, 20);
+
+    state.propose(VOLUME, 40);
+    // not settled while the command is running
+    QCOMPARE(state.settle(100000), qint64(-1));
+    state.commandDone(VOLUME, true, 1000);
+
+    QCOMPARE(state.settle(1000), qint64(OptimisticState::SETTLE_TIME));
+    QCOMPARE(entity.values.value(VOLUME), QVariant(40));
+    QCOMPARE(state.settle(1000 + OptimisticState::SETTLE_TIME), qint64(-1));
+    QVERIFY(!state.isPending(VOLUME));
+    QCOMPARE(entity.values.value(VOLUME), QVariant(20));
+}
+
+QTEST_GUILESS_MAIN(TestOptimisticState)
+#include "tst_optimisticstate.moc"
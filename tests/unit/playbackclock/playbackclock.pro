@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET    = tst_playbackclock
+HEADERS  += $$SRC_PATH/playbackclock.h
+SOURCES  += $$SRC_PATH/playbackclock.cpp \
+            tst_playbackclock.cpp
@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QtTest>
+
+#include "playbackclock.h"
+
+class TestPlaybackClock : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void invalidByDefault();
+    void extrapolatesWhilePlaying();
+    void holdsWhilePaused();
+    void clampedToDuration();
+    void clear();
+};
+
+void TestPlaybackClock::invalidByDefault() {
+    PlaybackClock clock;
+    QVERIFY(!clock.isValid());
+    QVERIFY(!clock.isPlaying());
+    QCOMPARE(clock.position(1000), qint64(0));
+}
+
+void TestPlaybackClock::extrapolatesWhilePlaying() {
+    PlaybackClock clock;
+    clock.anchor(10000, 240000, true, 5000);
+    QVERIFY(clock.isPlaying());
+    QCOMPARE(clock.position(5000), qint64(10000));
+    QCOMPARE(clock.position(8500), qint64(13500));
+    // a clock read before the anchor does not go back
+    QCOMPARE(clock.position(4000), qint64(10000));
+}
+
+void TestPlaybackClock::holdsWhilePaused() {
+    PlaybackClock clock;
+    clock.anchor(10000, 240000, false, 5000);
+    QVERIFY(clock.isValid());
+    QVERIFY(!clock.isPlaying());
+    QCOMPARE(clock.position(60000), qint64(10000));
+}
+
+void TestPlaybackClock::clampedToDuration() {
+    PlaybackClock clock;
+    clock.anchor(239000, 240000, true, 0);
+    QCOMPARE(clock.position(5000), qint64(240000));
+
+    // live streams have no duration
+    clock.anchor(239000, 0, true, 0);
+    QCOMPARE(clock.position(5000), qint64(244000));
+}
+
+void TestPlaybackClock::clear() {
+    PlaybackClock clock;
+    clock.anchor(10000, 240000, true, 0);
+    clock.clear();
+    QVERIFY(!clock.isValid());
+    QCOMPARE(clock.duration(), qint64(0));
+    QCOMPARE(clock.position(1000), qint64(0));
+}
+
+QTEST_GUILESS_MAIN(TestPlaybackClock)
+#include "tst_playbackclock.moc"
@@ -0,0 +1,6 @@
+include(../../tests.pri)
+
+TARGET    = tst_reconnectbackoff
+HEADERS  += $$SRC_PATH/reconnectbackoff.h
+SOURCES  += $$SRC_PATH/reconnectbackoff.cpp \
+            tst_reconnectbackoff.cpp
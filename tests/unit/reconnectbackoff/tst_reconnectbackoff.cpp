@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Marton Borzak <hello@martonborzak.com>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include <QtTest>
+
+#include "reconnectbackoff.h"
+
+class TestReconnectBackoff : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void doublesUpToMaximum();
+    void jitterBounds();
+    void reset();
+};
+
+void TestReconnectBackoff::doublesUpToMaximum() {
+    ReconnectBackoff backoff(1000, 8000, 0.0);
+    QList<int>       delays;
+    for (int i = 0; i < 6; i++) {
+        delays.append(backoff.nextDelay());
+    }
+    QCOMPARE(delays, QList<int>({1000, 2000, 4000, 8000, 8000, 8000}));
+    QCOMPARE(backoff.attempts(), 6);
+}
+
+void TestReconnectBackoff::jitterBounds() {
+    // products dropped at the same time must not all retry at the same time
+    ReconnectBackoff backoff(1000, 1000, 0.2);
+    int              minimum = 1000;
+    int              maximum = 1000;
+    for (int i = 0; i < 1000; i++) {
+        int delay = backoff.nextDelay();
+        QVERIFY2(delay >= 800 && delay <= 1200, qPrintable(QString::number(delay)));
+        minimum = qMin(minimum, delay);
+        maximum = qMax(maximum, delay);
+    }
+    QVERIFY(minimum < 950);
+    QVERIFY(maximum > 1050);
+}
+
+void TestReconnectBackoff::reset() {
+    ReconnectBackoff backoff(500, 60000, 0.0);
+    backoff.nextDelay();
+    backoff.nextDelay();
+    backoff.reset();
+    QCOMPARE(backoff.attempts(), 0);
+    QCOMPARE(backoff.nextDelay(), 500);
+}
+
+QTEST_GUILESS_MAIN(TestReconnectBackoff)
+#include "tst_reconnectbackoff.moc"
@@ -0,0 +1,11 @@
+TEMPLATE  = subdirs
+CONFIG   += testcase_targets
+SUBDIRS   = beohttpclient \
+            beostandin \
+            commandcoalescer \
+            notificationdecoder \
+            notificationfilter \
+            notificationframer \
+            optimisticstate \
+            playbackclock \
+            reconnectbackoff